@@ -0,0 +1,55 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  backbone.cpp
+ *
+ *    Description:  Implementation of the analysis of the values of all the solutions of a grid
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 01:40:13
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include "backbone.h"
+#include "sat.h"
+
+using namespace std;
+
+Backbone::Backbone(const Grid &grid):_dim2(grid.dim2()),_solvable(false),_supported(_dim2*_dim2*_dim2,0),_forced(_dim2*_dim2,0),_nsearches(0) {
+	size_t d2=_dim2;
+	SatGrid sat(grid);
+	SatSolver &solver=sat.solver();
+	// A solution supports all its values
+	auto witness=[&]() {
+		for (size_t c=0;c<d2*d2;++c) {
+			elem_t v=grid(c/d2,c%d2)->value;
+			if (v==0) for (v=1;v<=d2 && (sat.variable(c,v)==0 || !solver.value(sat.variable(c,v)));++v);
+			_supported[c*d2+v-1]=1;
+		}
+	};
+	++_nsearches;
+	if (solver.solve()!=SatSolver::SATISFIABLE) return;
+	_solvable=true;
+	witness();
+	for (size_t c=0;c<d2*d2;++c) for (elem_t v=1;v<=d2;++v) {
+		int var=sat.variable(c,v);
+		if (var==0 || _supported[c*d2+v-1]) continue;
+		++_nsearches;
+		if (solver.solve(vector<int>(1,var))==SatSolver::SATISFIABLE) witness();
+		else solver.add_clause({-var});	// The value is in no solution, the next searches know it
+	}
+	for (size_t c=0;c<d2*d2;++c) {
+		size_t n=0;
+		for (elem_t v=1;v<=d2;++v) if (_supported[c*d2+v-1]) {
+			++n;
+			_forced[c]=v;
+		}
+		if (n!=1) _forced[c]=0;
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  backbone.h
+ *
+ *    Description:  Definition of the analysis of the values of all the solutions of a grid
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 01:22:46
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  BACKBONE_INC
+#define  BACKBONE_INC
+
+#include <vector>
+#include "objects.h"
+
+/**
+ * \brief Values of a grid across all its solutions
+ *
+ * The class finds, for each cell of a grid, the values which appear in at least one of its solutions, and the value the cell holds in all of them when there is only one. The backbone of the grid is the set of these forced values.
+ * The solutions are not enumerated. The grid is encoded once as a boolean formula with SatGrid, and each value of a cell is checked by a search which assumes it, so that the clauses learnt by a search help the following ones. Each solution found is a witness for all the values it holds, which do not need to be checked again, and each value without solution is added to the formula as a forbidden value. The number of searches is at most the number of candidate values of the grid, and most of the time much lower.
+ */
+class Backbone {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor runs the analysis.
+		 * \param grid Grid to analyse
+		 */
+		Backbone(const Grid &grid);
+
+		bool solvable() const {return _solvable;}	//!< Tell if the grid has at least one solution
+
+		/**
+		 * \brief Tell if a value appears in a solution
+		 *
+		 * \param row Row index of the cell
+		 * \param column Column index of the cell
+		 * \param value Value of the cell
+		 * \return True if at least one solution of the grid has this value in the cell
+		 */
+		bool supported(size_t row,size_t column,elem_t value) const {return _supported[(row*_dim2+column)*_dim2+value-1]!=0;}
+
+		/**
+		 * \brief Value of a cell in all the solutions
+		 *
+		 * \param row Row index of the cell
+		 * \param column Column index of the cell
+		 * \return Value held by the cell in all the solutions of the grid, or 0 if the solutions do not agree or if there is no solution
+		 */
+		elem_t forced(size_t row,size_t column) const {return _forced[row*_dim2+column];}
+
+		size_t nsearches() const {return _nsearches;}	//!< Number of searches of the analysis
+
+	private:
+		size_t _dim2;	//!< Number of rows of the grid
+		bool _solvable;	//!< Tell if the grid has a solution
+		std::vector<char> _supported;	//!< Tell for each value of each cell, at index cell*dim2+value-1, if it appears in a solution
+		std::vector<elem_t> _forced;	//!< Value of each cell in all the solutions, 0 if there is none
+		size_t _nsearches;	//!< Number of searches of the analysis
+};
+
+#endif   /* ----- #ifndef BACKBONE_INC  ----- */
@@ -0,0 +1,94 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  background.cpp
+ *
+ *    Description:  Implementation of the generation of grids in a background thread
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 18:21:02
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include "background.h"
+#include "geometry.h"
+
+using namespace std;
+
+BackgroundGenerator::BackgroundGenerator():_stop(false),_quit(false),_pending(false),_running(false),_ready(false),_dimension(0),_difficulty(0),_worker(&BackgroundGenerator::work,this) {}
+
+BackgroundGenerator::~BackgroundGenerator() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_quit=true;
+		_stop.store(true);
+	}
+	_cv.notify_one();
+	_worker.join();
+}
+
+void BackgroundGenerator::request(size_t dimension,size_t difficulty) {
+	lock_guard<mutex> lock(_mutex);
+	if (dimension==_dimension && difficulty==_difficulty && (_ready || _pending || (_running && !_stop.load()))) return;
+	_dimension=dimension;
+	_difficulty=difficulty;
+	_ready=false;
+	_puzzle=Grid();
+	_solution=Grid();
+	if (_running) _stop.store(true);
+	_pending=true;
+	_cv.notify_one();
+}
+
+bool BackgroundGenerator::take(size_t dimension,size_t difficulty,Grid &puzzle,Grid &solution) {
+	lock_guard<mutex> lock(_mutex);
+	if (!_ready || dimension!=_dimension || difficulty!=_difficulty) return false;
+	puzzle=std::move(_puzzle);
+	solution=std::move(_solution);
+	_ready=false;
+	// Prepare the next game speculatively
+	_pending=true;
+	_cv.notify_one();
+	return true;
+}
+
+void BackgroundGenerator::cancel() {
+	lock_guard<mutex> lock(_mutex);
+	_pending=false;
+	if (_running) _stop.store(true);
+}
+
+bool BackgroundGenerator::busy() const {
+	lock_guard<mutex> lock(_mutex);
+	return _pending || (_running && !_stop.load());
+}
+
+void BackgroundGenerator::work() {
+	unique_lock<mutex> lock(_mutex);
+	while (true) {
+		_cv.wait(lock,[this] {return _pending || _quit;});
+		if (_quit) break;
+		size_t dimension=_dimension;
+		size_t difficulty=_difficulty;
+		_pending=false;
+		_running=true;
+		_stop.store(false);
+		lock.unlock();
+		Grid solution;
+		Grid puzzle=Grid::generate(Geometry::standard(dimension),difficulty,&solution,false,&_stop);
+		lock.lock();
+		_running=false;
+		// The result is dropped if the generation has been cancelled or if another grid has been requested meanwhile
+		if (puzzle.dim2()!=0 && !_stop.load() && dimension==_dimension && difficulty==_difficulty) {
+			_puzzle=std::move(puzzle);
+			_solution=std::move(solution);
+			_ready=true;
+		}
+	}
+}
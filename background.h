@@ -0,0 +1,98 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  background.h
+ *
+ *    Description:  Definition of the generation of grids in a background thread
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 18:05:37
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  BACKGROUND_INC
+#define  BACKGROUND_INC
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "objects.h"
+
+/**
+ * \brief Generator of grids running in a background thread
+ *
+ * The class owns a worker thread which calls Grid::generate, so that the thread handling the user input is never blocked by the generation. Only one grid is generated at a time, and only one generated grid is kept until it is taken.
+ * A grid is requested by BackgroundGenerator::request and collected by BackgroundGenerator::take, which immediately requests the next grid with the same parameters. The next puzzle is therefore generated speculatively while the current one is played, and it is usually ready when a new game is started.
+ * All the methods are called from the same thread, they never wait for the generation.
+ */
+class BackgroundGenerator {
+	public:
+		BackgroundGenerator();	//!< Standard constructor, starting the worker thread
+
+		/**
+		 * \brief Standard destructor
+		 *
+		 * The destructor cancels the current generation and waits for the end of the worker thread.
+		 */
+		~BackgroundGenerator();
+
+		/**
+		 * \brief Request a grid
+		 *
+		 * If a grid with the same parameters is already generated or being generated, the method does nothing. Otherwise, the current generation is cancelled, the grid kept is dropped and the generation of the new grid starts.
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty, see Grid::generate
+		 */
+		void request(size_t dimension,size_t difficulty);
+
+		/**
+		 * \brief Take a generated grid
+		 *
+		 * If a grid with the given parameters is ready, the method moves it to the arguments and requests the next one with the same parameters.
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty
+		 * \param puzzle Grid where the puzzle is stored, its values are marked as fixed
+		 * \param solution Grid where the solution of the puzzle is stored
+		 * \return True if a grid was ready, false otherwise
+		 */
+		bool take(size_t dimension,size_t difficulty,Grid &puzzle,Grid &solution);
+
+		/**
+		 * \brief Cancel the current generation
+		 *
+		 * The grid already generated, if any, is kept.
+		 */
+		void cancel();
+
+		/**
+		 * \brief Tell if a grid is being generated
+		 *
+		 * \return True if a generation is running or waiting to start
+		 */
+		bool busy() const;
+
+	private:
+		mutable std::mutex _mutex;	//!< Mutex protecting the state of the generator
+		std::condition_variable _cv;	//!< Condition variable waking up the worker thread when a grid is requested
+		std::atomic<bool> _stop;	//!< Flag telling the current generation to abort
+		bool _quit;	//!< Tell the worker thread to terminate
+		bool _pending;	//!< Tell if a grid has been requested and its generation has not started yet
+		bool _running;	//!< Tell if a grid is being generated
+		bool _ready;	//!< Tell if a generated grid is waiting to be taken
+		size_t _dimension;	//!< Dimension of the last requested grid
+		size_t _difficulty;	//!< Level of difficulty of the last requested grid
+		Grid _puzzle;	//!< Generated puzzle waiting to be taken
+		Grid _solution;	//!< Solution of the generated puzzle
+		std::thread _worker;	//!< Worker thread, it must be the last member so that it starts when all the others are initialized
+
+		void work();	//!< Main loop of the worker thread
+};
+
+#endif   /* ----- #ifndef BACKGROUND_INC  ----- */
@@ -0,0 +1,229 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bank.cpp
+ *
+ *    Description:  Implementation of the on-disk bank of pregenerated puzzles
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 09:40:12
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <utility>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "bank.h"
+
+using namespace std;
+
+static const char bank_magic[8]={'S','U','D','O','K','U','B','K'};	//!< Magic string at the beginning of a bank file
+static const uint32_t bank_version=1;	//!< Current version of the format of bank files
+
+/**
+ * \brief Exclusive lock on a bank file
+ *
+ * The lock is taken with flock on a companion file whose name is the name of the bank followed by ".lock". It can not be taken on the bank itself, because PuzzleBank::refill replaces the file and a process which opens the new file would not see a lock held on the old one. The lock is released when the object is destroyed.
+ */
+class BankLock {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor waits until the lock is free and takes it. It throws a SudokuException if the lock file can not be opened.
+		 * \param path Path of the bank file
+		 */
+		BankLock(const string &path) {
+			_fd=::open((path+".lock").c_str(),O_RDWR | O_CREAT,0644);
+			if (_fd<0) throw SudokuException(SudokuException::IO_ERROR,"Unable to lock the bank file "+path+".");
+			while (flock(_fd,LOCK_EX)!=0 && errno==EINTR);
+		}
+
+		/**
+		 * \brief Standard destructor
+		 *
+		 * The destructor closes the lock file, which releases the lock.
+		 */
+		~BankLock() {::close(_fd);}
+
+	private:
+		int _fd;	//!< File descriptor of the lock file
+};
+
+PuzzleBank::PuzzleBank(const std::string &ppath):_path(ppath),_fd(-1),_data(0),_size(0) {
+	open();
+}
+
+PuzzleBank::~PuzzleBank() {
+	close();
+}
+
+void PuzzleBank::open() {
+	_fd=::open(_path.c_str(),O_RDWR);
+	if (_fd<0) return;
+	struct stat st;
+	if (fstat(_fd,&st)!=0 || (size_t)st.st_size<sizeof(Header)) {
+		close();
+		throw SudokuException(SudokuException::FORMAT_ERROR,"The bank file "+_path+" is truncated.");
+	}
+	_size=st.st_size;
+	void *addr=mmap(0,_size,PROT_READ | PROT_WRITE,MAP_SHARED,_fd,0);
+	if (addr==MAP_FAILED) {
+		close();
+		throw SudokuException(SudokuException::IO_ERROR,"Unable to map the bank file "+_path+".");
+	}
+	_data=(unsigned char*)addr;
+	const Header *header=(const Header*)_data;
+	if (memcmp(header->magic,bank_magic,sizeof(bank_magic))!=0 || header->version!=bank_version || sizeof(Header)+header->nbuckets*sizeof(Bucket)>_size) {
+		close();
+		throw SudokuException(SudokuException::FORMAT_ERROR,"The file "+_path+" is not a valid puzzle bank.");
+	}
+	for (size_t i=0;i<nbuckets();++i) {
+		const Bucket &b=buckets()[i];
+		if (b.served>b.count || b.offset+b.count*record_size(b.dimension)>_size) {
+			close();
+			throw SudokuException(SudokuException::FORMAT_ERROR,"The index of the bank file "+_path+" is corrupted.");
+		}
+	}
+}
+
+void PuzzleBank::close() {
+	if (_data!=0) {
+		munmap(_data,_size);
+		_data=0;
+	}
+	_size=0;
+	if (_fd>=0) {
+		::close(_fd);
+		_fd=-1;
+	}
+}
+
+void PuzzleBank::reopen() {
+	struct stat path_st,fd_st;
+	if (stat(_path.c_str(),&path_st)!=0) return;
+	if (_fd>=0 && fstat(_fd,&fd_st)==0 && fd_st.st_dev==path_st.st_dev && fd_st.st_ino==path_st.st_ino) return;
+	close();
+	open();
+}
+
+PuzzleBank::Bucket *PuzzleBank::find(size_t dimension,size_t difficulty) const {
+	for (size_t i=0;i<nbuckets();++i) {
+		Bucket *b=buckets()+i;
+		if (b->dimension==dimension && b->difficulty==difficulty) return b;
+	}
+	return 0;
+}
+
+size_t PuzzleBank::available(size_t dimension,size_t difficulty) const {
+	const Bucket *b=find(dimension,difficulty);
+	return (b==0)?0:(b->count-b->served);
+}
+
+bool PuzzleBank::draw(size_t dimension,size_t difficulty,Grid &puzzle,Grid *solution) {
+	BankLock lock(_path);
+	reopen();
+	Bucket *b=find(dimension,difficulty);
+	if (b==0 || b->served>=b->count) return false;
+	const unsigned char *record=_data+b->offset+b->served*record_size(dimension);
+	b->served++;
+	puzzle=Grid(dimension,record,true);
+	if (solution!=0) *solution=Grid(dimension,record+record_size(dimension)/2,false);
+	return true;
+}
+
+void PuzzleBank::refill(size_t dimension,size_t difficulty,size_t count,std::function<void(size_t)> progress) {
+	// Generate the new puzzles before taking the lock, so that other processes can still draw puzzles meanwhile
+	vector<unsigned char> fresh;
+	size_t rs=record_size(dimension);
+	for (size_t i=0;i<count;++i) {
+		Grid solution;
+		Grid puzzle=Grid::generate(dimension,difficulty,&solution);
+		fresh.resize(fresh.size()+rs);
+		puzzle.write_packed(&fresh[fresh.size()-rs]);
+		solution.write_packed(&fresh[fresh.size()-rs/2]);
+		if (progress!=0) progress(i+1);
+	}
+	// Gather the records which have not been served yet, the counters are read under the lock so that no draw of another process is lost
+	BankLock lock(_path);
+	reopen();
+	map<pair<size_t,size_t>,vector<unsigned char> > records;
+	for (size_t i=0;i<nbuckets();++i) {
+		const Bucket &b=buckets()[i];
+		size_t brs=record_size(b.dimension);
+		vector<unsigned char> &v=records[make_pair((size_t)b.dimension,(size_t)b.difficulty)];
+		v.insert(v.end(),_data+b.offset+b.served*brs,_data+b.offset+b.count*brs);
+	}
+	vector<unsigned char> &v=records[make_pair(dimension,difficulty)];
+	v.insert(v.end(),fresh.begin(),fresh.end());
+	// Write the new file and replace the old one
+	string tmppath=_path+".tmp";
+	ofstream ofs(tmppath.c_str(),ios::binary | ios::trunc);
+	if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create the bank file "+tmppath+".");
+	Header header;
+	memcpy(header.magic,bank_magic,sizeof(bank_magic));
+	header.version=bank_version;
+	header.nbuckets=records.size();
+	ofs.write((const char*)&header,sizeof(header));
+	uint64_t offset=sizeof(Header)+records.size()*sizeof(Bucket);
+	for (map<pair<size_t,size_t>,vector<unsigned char> >::const_iterator it=records.begin();it!=records.end();++it) {
+		Bucket b;
+		b.dimension=it->first.first;
+		b.difficulty=it->first.second;
+		b.offset=offset;
+		b.count=it->second.size()/record_size(b.dimension);
+		b.served=0;
+		ofs.write((const char*)&b,sizeof(b));
+		offset+=it->second.size();
+	}
+	for (map<pair<size_t,size_t>,vector<unsigned char> >::const_iterator it=records.begin();it!=records.end();++it) if (!it->second.empty()) ofs.write((const char*)&it->second[0],it->second.size());
+	ofs.close();
+	if (!ofs) {
+		unlink(tmppath.c_str());
+		throw SudokuException(SudokuException::IO_ERROR,"Unable to write the bank file "+tmppath+".");
+	}
+	if (rename(tmppath.c_str(),_path.c_str())!=0) {
+		unlink(tmppath.c_str());
+		throw SudokuException(SudokuException::IO_ERROR,"Unable to replace the bank file "+_path+".");
+	}
+	// The old file stays mapped until the new one is opened, so that the bank is still usable if the new file can not be opened
+	int fd=_fd;
+	unsigned char *data=_data;
+	size_t size=_size;
+	_fd=-1;
+	_data=0;
+	_size=0;
+	try {
+		open();
+	} catch (SudokuException &e) {
+		_fd=fd;
+		_data=data;
+		_size=size;
+		throw;
+	}
+	if (data!=0) munmap(data,size);
+	if (fd>=0) ::close(fd);
+}
+
+void PuzzleBank::write_summary(std::ostream &out) const {
+	for (size_t i=0;i<nbuckets();++i) {
+		const Bucket &b=buckets()[i];
+		out << b.dimension << '\t' << b.difficulty << '\t' << (b.count-b.served) << '\t' << b.served << '\n';
+	}
+}
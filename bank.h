@@ -0,0 +1,167 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bank.h
+ *
+ *    Description:  Definition of the on-disk bank of pregenerated puzzles
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 09:12:40
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  BANK_INC
+#define  BANK_INC
+
+#include <string>
+#include <cstdint>
+#include "objects.h"
+
+/**
+ * \brief Bank of pregenerated puzzles
+ *
+ * The class gives access to a file holding puzzles generated in advance, together with their solutions, so that a new game can be started instantly whatever the dimension of the grid.
+ * The file is memory-mapped. It starts with a header and an index of buckets, one bucket for each couple (dimension,difficulty). Each bucket points to a contiguous array of records, and each record holds the packed puzzle followed by the packed solution (see Grid::write_packed).
+ * Every bucket also stores the number of records already served. Puzzles are drawn in order and the counter is updated in place in the file, so that a puzzle is never served twice, even across sessions. The draws and the refills of all the processes sharing the file are serialized by a lock, see BankLock.
+ */
+class PuzzleBank {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The standard constructor opens the bank file and maps it in memory. If the file does not exist, the bank is considered empty and it will be created by the first call to PuzzleBank::refill.
+		 * \param ppath Path of the bank file
+		 */
+		PuzzleBank(const std::string &ppath);
+
+		/**
+		 * \brief Standard destructor
+		 *
+		 * The standard destructor unmaps the file and closes it.
+		 */
+		~PuzzleBank();
+
+		/**
+		 * \brief Draw a puzzle from the bank
+		 *
+		 * This method takes the next unserved puzzle of the bucket (dimension,difficulty) and marks it as served in the file. It runs in constant time.
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty, see Grid::generate
+		 * \param puzzle Grid where the puzzle is stored, its values are marked as fixed
+		 * \param solution If the pointer is not null, the solution of the puzzle is stored there
+		 * \return True if a puzzle was available, false if the bucket is empty
+		 */
+		bool draw(size_t dimension,size_t difficulty,Grid &puzzle,Grid *solution=0);
+
+		/**
+		 * \brief Number of puzzles available
+		 *
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty
+		 * \return Number of puzzles of the bucket which have not been served yet
+		 */
+		size_t available(size_t dimension,size_t difficulty) const;
+
+		/**
+		 * \brief Add new puzzles to the bank
+		 *
+		 * This method generates new puzzles and adds them to the bucket (dimension,difficulty). The puzzles are generated first, then the file is rewritten under the lock in a temporary file which replaces the old one when it is complete, and puzzles already served are dropped from all buckets. If any step fails, the old file stays opened.
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty
+		 * \param count Number of puzzles to generate
+		 * \param progress Callback function called after each generated puzzle with the number of puzzles generated so far, may be null
+		 */
+		void refill(size_t dimension,size_t difficulty,size_t count,std::function<void(size_t)> progress=0);
+
+		/**
+		 * \brief Write a summary of the bank
+		 *
+		 * The method writes one line per bucket with the dimension, the difficulty, the number of puzzles available and the number of puzzles already served.
+		 * \param out Output stream
+		 */
+		void write_summary(std::ostream &out) const;
+
+	private:
+		/**
+		 * \brief Header of the bank file
+		 */
+		struct Header {
+			char magic[8];	//!< Magic string identifying the file, always "SUDOKUBK"
+			uint32_t version;	//!< Version of the file format
+			uint32_t nbuckets;	//!< Number of buckets in the index
+		};
+
+		/**
+		 * \brief Entry of the index of the bank file
+		 */
+		struct Bucket {
+			uint32_t dimension;	//!< Dimension of the grids of the bucket
+			uint32_t difficulty;	//!< Level of difficulty of the grids of the bucket
+			uint64_t offset;	//!< Offset of the first record of the bucket from the beginning of the file
+			uint64_t count;	//!< Number of records in the bucket
+			uint64_t served;	//!< Number of records already served
+		};
+
+		std::string _path;	//!< Path of the bank file
+		int _fd;	//!< File descriptor of the bank file, -1 if it is not opened
+		unsigned char *_data;	//!< Address where the file is mapped, null if the bank is empty
+		size_t _size;	//!< Size of the mapped file
+
+		/**
+		 * \brief Map the bank file in memory
+		 *
+		 * The method opens the file and checks its header. If the file does not exist, the bank is left empty.
+		 */
+		void open();
+
+		/**
+		 * \brief Unmap and close the bank file
+		 */
+		void close();
+
+		/**
+		 * \brief Map the bank file again if it was replaced
+		 *
+		 * The method compares the file opened by the object with the file found at its path, and opens the new one if another process replaced it with PuzzleBank::refill. It must be called with the lock of the bank held.
+		 */
+		void reopen();
+
+		/**
+		 * \brief Index of buckets
+		 *
+		 * \return Pointer to the first entry of the index, which immediately follows the header in the file
+		 */
+		Bucket *buckets() const {return (Bucket*)(_data+sizeof(Header));}
+
+		/**
+		 * \brief Number of buckets in the index
+		 *
+		 * \return Number of buckets, 0 if the bank is empty
+		 */
+		size_t nbuckets() const {return (_data==0)?0:((const Header*)_data)->nbuckets;}
+
+		/**
+		 * \brief Find a bucket in the index
+		 *
+		 * \param dimension Dimension of the grid
+		 * \param difficulty Level of difficulty
+		 * \return Pointer to the bucket, or null if there is no bucket for this couple
+		 */
+		Bucket *find(size_t dimension,size_t difficulty) const;
+
+		/**
+		 * \brief Size of a record
+		 *
+		 * \param dimension Dimension of the grid
+		 * \return Number of bytes taken by a record (puzzle and solution) for this dimension
+		 */
+		static size_t record_size(size_t dimension) {return 2*dimension*dimension*dimension*dimension;}
+};
+
+#endif   /* ----- #ifndef BANK_INC  ----- */
@@ -0,0 +1,217 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  batch.cpp
+ *
+ *    Description:  Implementation of the solver of batches of grids
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 19:24:10
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include "batch.h"
+
+using namespace std;
+
+BatchSolver::BatchSolver(shared_ptr<const Geometry> pgeometry):_geometry(pgeometry),_ncells(pgeometry->ncells()),_full((uint16_t)((1u<<pgeometry->dim2())-1)),_masks(_ncells*lanes,0),_dead(lanes,0),_dirty(_ncells,0),_dirtyunits(pgeometry->nunits(),0),_puzzle(lanes,0),_stacks(lanes),_width(0) {
+	if (pgeometry->dim2()>16) throw SudokuException(SudokuException::FORMAT_ERROR,"Batches can only be solved for grids of at most 16 rows.");
+}
+
+void BatchSolver::propagate() {
+	const size_t d2=_geometry->dim2();
+	uint16_t single[lanes];
+	uint16_t once[lanes];
+	uint16_t twice[lanes];
+	bool changed=true;
+	while (changed) {
+		changed=false;
+		// Naked singles, the only candidate of a changed cell is removed from its peers
+		for (size_t c=0;c<_ncells;++c) {
+			if (!_dirty[c]) continue;
+			_dirty[c]=0;
+			const size_t *units=_geometry->units(c);
+			for (size_t u=0;u<_geometry->degree(c);++u) _dirtyunits[units[u]]=1;
+			const uint16_t *m=&_masks[c*lanes];
+			uint16_t any=0;
+			for (size_t l=0;l<lanes;++l) {
+				single[l]=(m[l]&(m[l]-1))?0:m[l];
+				any|=single[l];
+			}
+			if (any==0) continue;
+			const size_t *peers=_geometry->peers(c);
+			for (size_t k=0;k<_geometry->npeers(c);++k) {
+				uint16_t *p=&_masks[peers[k]*lanes];
+				uint16_t diff=0;
+				for (size_t l=0;l<lanes;++l) {
+					uint16_t n=p[l]&~single[l];
+					diff|=p[l]^n;
+					p[l]=n;
+				}
+				if (diff!=0) {
+					_dirty[peers[k]]=1;
+					changed=true;
+				}
+			}
+		}
+		if (changed) continue;	// The hidden singles wait for the naked singles to be exhausted
+		// Hidden singles, a value which has only one place in a changed unit is put there
+		for (size_t u=0;u<_geometry->nunits();++u) {
+			if (!_dirtyunits[u]) continue;
+			_dirtyunits[u]=0;
+			const size_t *cells=_geometry->unit(u);
+			for (size_t l=0;l<lanes;++l) once[l]=twice[l]=0;
+			for (size_t i=0;i<d2;++i) {
+				const uint16_t *m=&_masks[cells[i]*lanes];
+				for (size_t l=0;l<lanes;++l) {
+					twice[l]|=once[l]&m[l];
+					once[l]|=m[l];
+				}
+			}
+			for (size_t l=0;l<lanes;++l) {
+				_dead[l]|=(once[l]!=_full);
+				once[l]&=~twice[l];
+			}
+			for (size_t i=0;i<d2;++i) {
+				uint16_t *m=&_masks[cells[i]*lanes];
+				uint16_t diff=0;
+				for (size_t l=0;l<lanes;++l) {
+					uint16_t h=m[l]&once[l];
+					uint16_t n=h?h:m[l];
+					diff|=m[l]^n;
+					m[l]=n;
+				}
+				if (diff!=0) {
+					_dirty[cells[i]]=1;
+					changed=true;
+				}
+			}
+		}
+	}
+}
+
+void BatchSolver::load(size_t lane,const unsigned char *puzzle) {
+	// The givens are removed from their peers by the first propagation
+	for (size_t c=0;c<_ncells;++c) _masks[c*lanes+lane]=(puzzle[c]==0)?_full:(uint16_t)(1u<<(puzzle[c]-1));
+	fill(_dirty.begin(),_dirty.end(),1);
+	_dead[lane]=0;
+	_stacks[lane].clear();
+}
+
+void BatchSolver::move_lane(size_t from,size_t to) {
+	for (size_t c=0;c<_ncells;++c) {
+		_masks[c*lanes+to]=_masks[c*lanes+from];
+		_masks[c*lanes+from]=0;
+	}
+	_stacks[to].swap(_stacks[from]);
+	_stacks[from].clear();
+	_puzzle[to]=_puzzle[from];
+	_dead[to]=_dead[from];
+	_dead[from]=0;
+}
+
+void BatchSolver::push(size_t lane) {
+	vector<uint16_t> &stack=_stacks[lane];
+	size_t base=stack.size();
+	stack.resize(base+_ncells);
+	for (size_t c=0;c<_ncells;++c) stack[base+c]=_masks[c*lanes+lane];
+}
+
+bool BatchSolver::pop(size_t lane) {
+	vector<uint16_t> &stack=_stacks[lane];
+	if (stack.empty()) return false;
+	size_t base=stack.size()-_ncells;
+	// The saved masks were propagated before the branch, only the cells which differ from the current ones are propagated again
+	for (size_t c=0;c<_ncells;++c) if (_masks[c*lanes+lane]!=stack[base+c]) {
+		_masks[c*lanes+lane]=stack[base+c];
+		_dirty[c]=1;
+	}
+	stack.resize(base);
+	return true;
+}
+
+size_t BatchSolver::solve(const vector<Grid> &puzzles,vector<Grid> &solutions) {
+	size_t d2=_geometry->dim2();
+	for (auto &p:puzzles) if (p.shared_geometry()!=_geometry) throw SudokuException(SudokuException::FORMAT_ERROR,"All the grids of a batch must have the geometry of the solver.");
+	vector<unsigned char> packed(puzzles.size()*_ncells);
+	vector<unsigned char> solved(packed.size());
+	for (size_t i=0;i<puzzles.size();++i) puzzles[i].write_packed(&packed[i*_ncells]);
+	size_t n=solve(packed.data(),puzzles.size(),solved.data());
+	solutions.clear();
+	solutions.resize(puzzles.size());
+	for (size_t i=0;i<puzzles.size();++i) if (solved[i*_ncells]!=0) {
+		solutions[i]=Grid(_geometry);
+		for (size_t c=0;c<_ncells;++c) solutions[i].set_value(c/d2,c%d2,solved[i*_ncells+c]);
+	}
+	return n;
+}
+
+size_t BatchSolver::solve(const unsigned char *puzzles,size_t count,unsigned char *solutions) {
+	fill(_masks.begin(),_masks.end(),0);
+	fill(_dirtyunits.begin(),_dirtyunits.end(),0);
+	size_t next=0;
+	size_t nsolved=0;
+	_width=0;
+	while (_width<lanes && next<count) {
+		_puzzle[_width]=next;
+		load(_width++,puzzles+(next++)*_ncells);
+	}
+	while (_width>0) {
+		fill(_dead.begin(),_dead.end(),0);
+		propagate();
+		size_t l=0;
+		while (l<_width) {
+			// Look for a contradiction and for the cell with the fewest candidates
+			bool dead=(_dead[l]!=0);
+			size_t best=_ncells;
+			int bestcount=_geometry->dim2()+1;
+			for (size_t c=0;c<_ncells && !dead;++c) {
+				uint16_t m=_masks[c*lanes+l];
+				int n=__builtin_popcount(m);
+				if (n==0) dead=true;
+				else if (n>1 && n<bestcount) {
+					best=c;
+					bestcount=n;
+				}
+			}
+			if (dead) {
+				if (pop(l)) {	// Go on with the next alternative of the last branch
+					++l;
+					continue;
+				}
+			} else if (best<_ncells) {	// Branch on the lowest candidate, the other ones are saved to backtrack
+				uint16_t &m=_masks[best*lanes+l];
+				uint16_t v=m&(uint16_t)(~m+1);
+				m&=~v;
+				push(l);
+				m=v;
+				_dirty[best]=1;
+				++l;
+				continue;
+			} else {	// Every cell has a single candidate
+				unsigned char *solution=solutions+_puzzle[l]*_ncells;
+				for (size_t c=0;c<_ncells;++c) solution[c]=__builtin_ctz(_masks[c*lanes+l])+1;
+				++nsolved;
+			}
+			// The lane is free, it takes the next puzzle, or the last lane in use is moved there
+			if (dead) fill(solutions+_puzzle[l]*_ncells,solutions+(_puzzle[l]+1)*_ncells,0);
+			if (next<count) {
+				_puzzle[l]=next;
+				load(l,puzzles+(next++)*_ncells);
+				++l;
+			} else {
+				--_width;
+				if (l<_width) move_lane(_width,l);
+				else for (size_t c=0;c<_ncells;++c) _masks[c*lanes+l]=0;
+			}
+		}
+	}
+	return nsolved;
+}
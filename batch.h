@@ -0,0 +1,120 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  batch.h
+ *
+ *    Description:  Definition of the solver of batches of grids
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 19:02:48
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  BATCH_INC
+#define  BATCH_INC
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "objects.h"
+#include "geometry.h"
+
+/**
+ * \brief Solver of many grids of the same geometry at once
+ *
+ * The class solves a batch of puzzles of at most 16 rows, for workloads where the throughput matters more than the time of each puzzle. The candidates of each cell are stored as bit masks, and the masks of BatchSolver::lanes puzzles are interleaved: the mask of a cell in all the puzzles are contiguous in memory. The propagation (naked singles and hidden singles) runs in lockstep on all the puzzles, with inner loops over the puzzles which the compiler turns into vector instructions. A cell is only propagated again when its masks change in one of the puzzles, and a unit when the masks of one of its cells change.
+ * When the propagation of a puzzle is stuck, it branches on the cell with the fewest candidates and saves its masks on its own stack, so that each puzzle backtracks independently. As soon as a puzzle is solved or proven impossible, its lane is given to the next puzzle of the batch. When no puzzle is left, the active lanes are compacted at the beginning so that the propagation only runs on them.
+ * Only one solution is looked for, as with Grid::FIND_ONE.
+ */
+class BatchSolver {
+	public:
+		static const size_t lanes=16;	//!< Number of puzzles propagated together
+
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor throws a SudokuException if the grids of the geometry have more than 16 rows.
+		 * \param pgeometry Geometry of all the grids solved
+		 */
+		BatchSolver(std::shared_ptr<const Geometry> pgeometry);
+
+		/**
+		 * \brief Solve a batch of packed puzzles
+		 *
+		 * The puzzles and the solutions are in the packed format of Grid::write_packed, one byte per cell. This is the fastest interface, since no Grid object is built.
+		 * \param puzzles Buffer holding the puzzles one after the other
+		 * \param count Number of puzzles
+		 * \param solutions Buffer receiving the solution of each puzzle, in the same order, or only zeros for a puzzle without solution. Its size must be the same as the one of the buffer of the puzzles.
+		 * \return Number of puzzles solved
+		 */
+		size_t solve(const unsigned char *puzzles,size_t count,unsigned char *solutions);
+
+		/**
+		 * \brief Solve a batch of puzzles
+		 *
+		 * This method is a wrapper to the previous one. It throws a SudokuException if a puzzle does not have the geometry of the solver.
+		 * \param puzzles Puzzles to solve
+		 * \param solutions Vector receiving the solution of each puzzle, in the same order, or an empty grid (with Grid::dim2 equal to 0) for a puzzle without solution
+		 * \return Number of puzzles solved
+		 */
+		size_t solve(const std::vector<Grid> &puzzles,std::vector<Grid> &solutions);
+
+	private:
+		std::shared_ptr<const Geometry> _geometry;	//!< Geometry of the grids
+		size_t _ncells;	//!< Number of cells of a grid
+		uint16_t _full;	//!< Mask holding all the values
+		std::vector<uint16_t> _masks;	//!< Candidates of the cells in all the lanes, at index cell*lanes+lane
+		std::vector<uint8_t> _dead;	//!< Tell for each lane if the propagation found a value missing from a unit
+		std::vector<uint8_t> _dirty;	//!< Tell for each cell if its masks changed in a lane since it was last propagated
+		std::vector<uint8_t> _dirtyunits;	//!< Tell for each unit if the masks of one of its cells changed since its hidden singles were last looked for
+		std::vector<size_t> _puzzle;	//!< Index of the puzzle of each lane
+		std::vector<std::vector<uint16_t> > _stacks;	//!< Saved masks of the alternatives left by the branches of each lane, one block of BatchSolver::_ncells masks per branch
+		size_t _width;	//!< Number of lanes in use, the active lanes are the first ones
+
+		/**
+		 * \brief Propagate the constraints in all the lanes in use until nothing changes
+		 *
+		 * Only the cells and the units which changed since the last propagation are visited. The loops over the lanes always run over the BatchSolver::lanes lanes, the lanes out of use holding empty masks, so that their number of iterations is known to the compiler.
+		 */
+		void propagate();
+
+		/**
+		 * \brief Load a puzzle in a lane
+		 *
+		 * \param lane Index of the lane
+		 * \param puzzle Packed puzzle, see Grid::write_packed
+		 */
+		void load(size_t lane,const unsigned char *puzzle);
+
+		/**
+		 * \brief Copy the masks of a lane to another lane
+		 *
+		 * The stack, the puzzle and the contradiction flag of the lane are moved too.
+		 * \param from Index of the source lane
+		 * \param to Index of the destination lane
+		 */
+		void move_lane(size_t from,size_t to);
+
+		/**
+		 * \brief Save the masks of a lane on its stack
+		 *
+		 * \param lane Index of the lane
+		 */
+		void push(size_t lane);
+
+		/**
+		 * \brief Restore the masks of a lane from the top of its stack
+		 *
+		 * \param lane Index of the lane
+		 * \return False if the stack is empty
+		 */
+		bool pop(size_t lane);
+};
+
+#endif   /* ----- #ifndef BATCH_INC  ----- */
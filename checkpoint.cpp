@@ -0,0 +1,92 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  checkpoint.cpp
+ *
+ *    Description:  Implementation of the checkpoints of long enumerations
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 23:14:05
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include "checkpoint.h"
+
+using namespace std;
+
+static const char checkpoint_magic[8]={'S','U','D','O','K','U','C','K'};	//!< Magic string at the beginning of a checkpoint file
+static const uint32_t checkpoint_version=1;	//!< Current version of the format of checkpoint files
+
+/**
+ * \brief Read a vector of integers from a checkpoint file
+ *
+ * The vector is stored as its size on 4 bytes followed by its elements.
+ * \param in Input stream
+ * \param v Vector receiving the elements
+ * \param maxsize Maximal size accepted, to detect corrupted files
+ * \return True if the vector has been read
+ */
+template<typename T,typename S> static bool read_vector(istream &in,vector<T> &v,size_t maxsize) {
+	uint32_t n;
+	if (!in.read((char*)&n,sizeof(n)) || n>maxsize) return false;
+	vector<S> buf(n);
+	if (n>0 && !in.read((char*)&buf[0],n*sizeof(S))) return false;
+	v.assign(buf.begin(),buf.end());
+	return true;
+}
+
+/**
+ * \brief Write a vector of integers in a checkpoint file
+ *
+ * \param out Output stream
+ * \param v Vector to write
+ */
+template<typename S,typename T> static void write_vector(ostream &out,const vector<T> &v) {
+	uint32_t n=v.size();
+	out.write((const char*)&n,sizeof(n));
+	vector<S> buf(v.begin(),v.end());
+	if (n>0) out.write((const char*)&buf[0],n*sizeof(S));
+}
+
+bool Checkpoint::read(const std::string &ppath) {
+	ifstream ifs(ppath.c_str(),ios::binary);
+	if (!ifs) return false;
+	char magic[sizeof(checkpoint_magic)];
+	uint32_t version;
+	uint64_t counters[3];
+	if (!ifs.read(magic,sizeof(magic)) || memcmp(magic,checkpoint_magic,sizeof(magic))!=0 || !ifs.read((char*)&version,sizeof(version)) || version!=checkpoint_version
+			|| !read_vector<unsigned char,unsigned char>(ifs,grid,1<<16)
+			|| !read_vector<size_t,uint32_t>(ifs,path,1<<16)
+			|| !ifs.read((char*)counters,sizeof(counters))
+			|| !read_vector<unsigned char,unsigned char>(ifs,previous,grid.size()))
+		throw SudokuException(SudokuException::FORMAT_ERROR,"The file "+ppath+" is not a valid checkpoint.");
+	solutions=counters[0];
+	nodes=counters[1];
+	offset=counters[2];
+	return true;
+}
+
+void Checkpoint::write(const std::string &ppath) const {
+	string tmppath=ppath+".tmp";
+	ofstream ofs(tmppath.c_str(),ios::binary | ios::trunc);
+	if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create the checkpoint file "+tmppath+".");
+	ofs.write(checkpoint_magic,sizeof(checkpoint_magic));
+	ofs.write((const char*)&checkpoint_version,sizeof(checkpoint_version));
+	write_vector<unsigned char>(ofs,grid);
+	write_vector<uint32_t>(ofs,path);
+	uint64_t counters[3]={solutions,nodes,offset};
+	ofs.write((const char*)counters,sizeof(counters));
+	write_vector<unsigned char>(ofs,previous);
+	ofs.close();
+	if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to write the checkpoint file "+tmppath+".");
+	if (rename(tmppath.c_str(),ppath.c_str())!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to replace the checkpoint file "+ppath+".");
+}
@@ -0,0 +1,61 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  checkpoint.h
+ *
+ *    Description:  Definition of the checkpoints of long enumerations
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 23:02:18
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  CHECKPOINT_INC
+#define  CHECKPOINT_INC
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "objects.h"
+
+/**
+ * \brief Checkpoint of an enumeration
+ *
+ * The class holds what is needed to resume an enumeration of Grid::enumerate in another process: the grid being solved, the path of the search, the counters and the state of the output. The file starts with a magic string and a version number, followed by the fields of the class in binary form.
+ */
+class Checkpoint {
+	public:
+		Checkpoint():solutions(0),nodes(0),offset(0) {}	//!< Standard constructor, for an enumeration which has not started
+
+		/**
+		 * \brief Read a checkpoint file
+		 *
+		 * The method throws a SudokuException if the file exists but is not a valid checkpoint.
+		 * \param ppath Path of the file
+		 * \return True if the checkpoint has been read, false if the file does not exist
+		 */
+		bool read(const std::string &ppath);
+
+		/**
+		 * \brief Write a checkpoint file
+		 *
+		 * The checkpoint is written in a temporary file which then replaces the previous one, so that the file always holds a complete checkpoint even if the process is killed while writing it. The method throws a SudokuException if the file could not be written.
+		 * \param ppath Path of the file
+		 */
+		void write(const std::string &ppath) const;
+
+		std::vector<unsigned char> grid;	//!< Grid being solved, in the packed format of Grid::write_packed
+		std::vector<size_t> path;	//!< Path of the search, see Grid::enumerate
+		uint64_t solutions;	//!< Number of solutions found before the path
+		uint64_t nodes;	//!< Number of hypotheses tried before the path
+		uint64_t offset;	//!< Size of the output holding the solutions found before the path
+		std::vector<unsigned char> previous;	//!< Last solution written in the output, in packed format, or empty vector if there is none
+};
+
+#endif   /* ----- #ifndef CHECKPOINT_INC  ----- */
@@ -0,0 +1,308 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  count.cpp
+ *
+ *    Description:  Implementation of the counting of the solutions of a grid
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 20:40:06
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include "count.h"
+
+using namespace std;
+
+string to_string(count_t n) {
+	if (n==0) return "0";
+	string s;
+	while (n>0) {
+		s.push_back('0'+(char)(n%10));
+		n/=10;
+	}
+	reverse(s.begin(),s.end());
+	return s;
+}
+
+size_t ModelCounter::KeyHash::operator()(const vector<uint64_t> &key) const {
+	uint64_t h=0xcbf29ce484222325ull;
+	for (uint64_t k:key) {
+		h^=k;
+		h*=0x100000001b3ull;
+		h^=h>>29;
+	}
+	return (size_t)h;
+}
+
+ModelCounter::ModelCounter(const Grid &grid,size_t pmaxentries):_geometry(grid.shared_geometry()),_masks(grid.dim2()*grid.dim2(),0),_mark(_masks.size(),0),_stamp(0),_maxentries(pmaxentries),_weighing(false),_nbranches(0),_nsplits(0),_nhits(0) {
+	size_t d2=grid.dim2();
+	if (d2>48) throw SudokuException(SudokuException::FORMAT_ERROR,"Solutions can only be counted for grids of at most 48 rows.");
+	if (_geometry->ncages()>0) throw SudokuException(SudokuException::FORMAT_ERROR,"Solutions cannot be counted for grids with cages.");
+	_unitmark.assign(_geometry->nunits(),0);
+	_values.assign(d2*d2,0);
+	for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) {
+		Cell *cell=grid(i,j);
+		_values[i*d2+j]=cell->value;
+		if (cell->value!=0) continue;
+		uint64_t m=0;
+		for (size_t v=0;v<d2;++v) if (cell->possible[v]) m|=1ull<<v;
+		_masks[i*d2+j]=m;
+		_empty.push_back(i*d2+j);
+	}
+	// A grid whose clues are in conflict has no solution, this is marked by an empty cell without possible value
+	for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) if (grid(i,j)->value!=0 && grid.conflicts(i,j)>0) {
+		_masks[i*d2+j]=0;
+		_empty.push_back(i*d2+j);
+	}
+}
+
+count_t ModelCounter::count() {
+	_nbranches=_nsplits=_nhits=0;
+	_cache.clear();
+	vector<uint64_t> masks=_masks;
+	try {
+		return count(_empty);
+	} catch (SudokuException&) {	// The masks are left as they were when the count overflowed
+		_masks=masks;
+		throw;
+	}
+}
+
+bool ModelCounter::propagate(vector<size_t> &cells) {
+	size_t d2=_geometry->dim2();
+	bool changed=true;
+	while (changed) {
+		changed=false;
+		// Naked singles, the value of a cell with only one possibility is removed from its peers
+		++_stamp;
+		for (size_t c:cells) _mark[c]=_stamp;
+		size_t k=0;
+		for (size_t i=0;i<cells.size();++i) {
+			size_t c=cells[i];
+			uint64_t m=_masks[c];
+			if (m==0) return false;
+			if ((m&(m-1))==0) {
+				const size_t *peers=_geometry->peers(c);
+				for (size_t p=0;p<_geometry->npeers(c);++p) if (_mark[peers[p]]==_stamp) _masks[peers[p]]&=~m;
+				_mark[c]=0;
+				changed=true;
+			} else cells[k++]=c;
+		}
+		cells.resize(k);
+		// Hidden singles, the cells of a unit must hold as many values as there are cells, so a value which has only one place must go there
+		++_stamp;
+		for (size_t c:cells) _mark[c]=_stamp;
+		for (size_t c:cells) {
+			const size_t *units=_geometry->units(c);
+			for (size_t u=0;u<_geometry->degree(c);++u) {
+				if (_unitmark[units[u]]==_stamp) continue;
+				_unitmark[units[u]]=_stamp;
+				const size_t *unit=_geometry->unit(units[u]);
+				uint64_t once=0,twice=0;
+				int n=0;
+				for (size_t i=0;i<d2;++i) if (_mark[unit[i]]==_stamp) {
+					uint64_t m=_masks[unit[i]];
+					twice|=once&m;
+					once|=m;
+					++n;
+				}
+				if (__builtin_popcountll(once)!=n) return false;
+				uint64_t hidden=once&~twice;
+				if (hidden==0) continue;
+				for (size_t i=0;i<d2;++i) if (_mark[unit[i]]==_stamp) {
+					uint64_t h=_masks[unit[i]]&hidden;
+					if (h==0 || h==_masks[unit[i]]) continue;
+					if ((h&(h-1))!=0) return false;	// Two values can only go in this cell
+					_masks[unit[i]]=h;
+					changed=true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+vector<vector<size_t> > ModelCounter::split(const vector<size_t> &cells) {
+	vector<vector<size_t> > components;
+	++_stamp;
+	for (size_t c:cells) _mark[c]=_stamp;
+	for (size_t c:cells) if (_mark[c]==_stamp) {
+		// Breadth-first search through the peers sharing a possible value
+		components.push_back(vector<size_t>(1,c));
+		vector<size_t> &component=components.back();
+		_mark[c]=0;
+		for (size_t k=0;k<component.size();++k) {
+			size_t x=component[k];
+			const size_t *peers=_geometry->peers(x);
+			for (size_t p=0;p<_geometry->npeers(x);++p) if (_mark[peers[p]]==_stamp && (_masks[peers[p]]&_masks[x])!=0) {
+				_mark[peers[p]]=0;
+				component.push_back(peers[p]);
+			}
+		}
+		sort(component.begin(),component.end());
+	}
+	return components;
+}
+
+vector<uint64_t> ModelCounter::key(const vector<size_t> &cells,int *labels) const {
+	vector<uint64_t> k;
+	k.reserve(cells.size());
+	int buffer[64];
+	int *label=(labels!=0)?labels:buffer;
+	fill(label,label+64,-1);
+	int next=0;
+	for (size_t c:cells) {
+		uint64_t m=_masks[c];
+		uint64_t renumbered=0;
+		while (m!=0) {
+			int v=__builtin_ctzll(m);
+			m&=m-1;
+			if (label[v]<0) label[v]=next++;
+			renumbered|=1ull<<label[v];
+		}
+		k.push_back(((uint64_t)c<<48)|renumbered);
+	}
+	return k;
+}
+
+count_t ModelCounter::count(vector<size_t> cells) {
+	vector<size_t> original=cells;
+	vector<uint64_t> saved(cells.size());
+	for (size_t i=0;i<cells.size();++i) saved[i]=_masks[cells[i]];
+	count_t result=0;
+	if (propagate(cells)) {
+		if (cells.empty()) result=1;
+		else {
+			vector<vector<size_t> > components=split(cells);
+			if (components.size()>1) {	// The count is the product of the counts of the independent components
+				++_nsplits;
+				result=1;
+				bool overflow=false;
+				for (size_t i=0;i<components.size() && result!=0;++i) {
+					count_t n=count(components[i]);
+					if (n==0) result=0;
+					else if (__builtin_mul_overflow(result,n,&result)) {	// A later component without solution still gives 0
+						overflow=true;
+						result=1;
+					}
+				}
+				if (overflow && result!=0) throw SudokuException(SudokuException::FORMAT_ERROR,"The number of solutions of the grid does not fit on 128 bits.");
+			} else {
+				vector<size_t> &component=components[0];
+				int label[64];
+				vector<uint64_t> k=key(component,label);
+				auto it=_cache.find(k);
+				if (it!=_cache.end()) {
+					++_nhits;
+					result=it->second;
+				} else {
+					// Branch on each possible value of the cell with the fewest possibilities
+					size_t best=component[0];
+					for (size_t c:component) if (__builtin_popcountll(_masks[c])<__builtin_popcountll(_masks[best])) best=c;
+					uint64_t m=_masks[best];
+					vector<count_t> weights;
+					for (uint64_t r=m;r!=0;r&=r-1) {
+						_masks[best]=r&(~r+1);
+						++_nbranches;
+						count_t n=count(component);
+						if (__builtin_add_overflow(result,n,&result)) throw SudokuException(SudokuException::FORMAT_ERROR,"The number of solutions of the grid does not fit on 128 bits.");
+						if (!_weighing) continue;
+						size_t v=label[__builtin_ctzll(r)];
+						if (weights.size()<=v) weights.resize(v+1,0);
+						weights[v]=n;
+					}
+					_masks[best]=m;
+					if (_weighing) {	// The numbers of solutions of the values are kept for the draws
+						if (_weights.size()>=_maxentries) _weights.clear();
+						_weights.emplace(k,std::move(weights));
+					}
+					if (_cache.size()>=_maxentries) _cache.clear();
+					_cache.emplace(std::move(k),result);
+				}
+			}
+		}
+	}
+	for (size_t i=0;i<original.size();++i) _masks[original[i]]=saved[i];
+	return result;
+}
+
+bool ModelCounter::sample(mt19937 &generator,vector<elem_t> &values) {
+	vector<uint64_t> masks=_masks;
+	_weighing=true;
+	bool found;
+	try {
+		found=(count(_empty)!=0);
+		if (found) {
+			values=_values;
+			sample(_empty,generator,values);
+		}
+	} catch (SudokuException&) {
+		_masks=masks;
+		_weighing=false;
+		throw;
+	}
+	_weighing=false;
+	return found;
+}
+
+void ModelCounter::sample(vector<size_t> cells,mt19937 &generator,vector<elem_t> &values) {
+	vector<size_t> original=cells;
+	vector<uint64_t> saved(cells.size());
+	for (size_t i=0;i<cells.size();++i) saved[i]=_masks[cells[i]];
+	propagate(cells);
+	// The cells which are not left in the set have received their value
+	++_stamp;
+	for (size_t c:cells) _mark[c]=_stamp;
+	for (size_t c:original) if (_mark[c]!=_stamp) values[c]=__builtin_ctzll(_masks[c])+1;
+	if (!cells.empty()) {
+		vector<vector<size_t> > components=split(cells);
+		if (components.size()>1) {	// The components are independent, each one is drawn separately
+			for (auto &component:components) sample(component,generator,values);
+		} else {
+			// Draw the value of the cell with the fewest possibilities, in proportion to the number of solutions of each value
+			vector<size_t> &component=components[0];
+			size_t best=component[0];
+			for (size_t c:component) if (__builtin_popcountll(_masks[c])<__builtin_popcountll(_masks[best])) best=c;
+			uint64_t m=_masks[best];
+			// The numbers of solutions of the values are stored with the key of the component, indexed by the renumbered values, they are only missing if the component was counted before the first draw or if the cache was cleared
+			int label[64];
+			vector<uint64_t> id=key(component,label);
+			auto it=_weights.find(id);
+			if (it==_weights.end()) {
+				vector<count_t> weights;
+				for (uint64_t r=m;r!=0;r&=r-1) {
+					size_t v=label[__builtin_ctzll(r)];
+					if (weights.size()<=v) weights.resize(v+1,0);
+					_masks[best]=r&(~r+1);
+					weights[v]=count(component);
+				}
+				_masks[best]=m;
+				if (_weights.size()>=_maxentries) _weights.clear();
+				it=_weights.emplace(std::move(id),std::move(weights)).first;
+			}
+			vector<uint64_t> choices;
+			vector<count_t> counts;
+			count_t total=0;
+			for (uint64_t r=m;r!=0;r&=r-1) {
+				choices.push_back(r&(~r+1));
+				counts.push_back(it->second[label[__builtin_ctzll(r)]]);
+				total+=counts.back();
+			}
+			// Uniform draw in [0,total) on 128 bits, the bias of the modulo is below 2^-50 for the counts of the grids of at most 9 values
+			count_t x=(((count_t)generator()<<96)|((count_t)generator()<<64)|((count_t)generator()<<32)|generator())%total;
+			size_t k=0;
+			while (x>=counts[k]) x-=counts[k++];
+			_masks[best]=choices[k];
+			sample(component,generator,values);
+		}
+	}
+	for (size_t i=0;i<original.size();++i) _masks[original[i]]=saved[i];
+}
@@ -0,0 +1,149 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  count.h
+ *
+ *    Description:  Definition of the counting of the solutions of a grid
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 20:12:31
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  COUNT_INC
+#define  COUNT_INC
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <random>
+#include "objects.h"
+#include "geometry.h"
+
+typedef unsigned __int128 count_t;	//!< Number of solutions, the number of full 9x9 grids does not fit on 64 bits, and the counts of larger grids may not fit either
+
+/**
+ * \brief Decimal representation of a number of solutions
+ *
+ * \param n Number of solutions
+ * \return Decimal representation of the number
+ */
+std::string to_string(count_t n);
+
+/**
+ * \brief Counter of the solutions of a grid
+ *
+ * The class counts the solutions of a grid without enumerating them. The empty cells and their possible values form a coloring problem, where two peers must hold different values. Two peers which have no possible value in common never constrain each other, so the empty cells split into independent components, and the number of solutions is the product of the numbers of solutions of the components.
+ * The counter propagates the naked and hidden singles, splits the remaining cells into components, counts each component separately and branches on the cell with the fewest possible values when a component cannot be split. The count of each component is stored in a cache, keyed by the cells of the component and their possible values. The values are renumbered in the order of their first appearance in the key, so that two components which only differ by a permutation of the values share the same entry.
+ * The counts also give uniformly random solutions: the solution is built along the same branches, each value of a branching cell being drawn with a probability proportional to the number of solutions it leads to. While the solutions are drawn, the counter also stores the numbers of solutions of the values of each branching cell in a second cache, keyed like the first one and kept from one solution drawn to the next, so that a draw only needs one lookup for each branch.
+ */
+class ModelCounter {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param grid Grid whose solutions are counted, it must hold at most 48 values
+		 * \param pmaxentries Number of entries of the cache above which it is cleared
+		 */
+		ModelCounter(const Grid &grid,size_t pmaxentries=1<<22);
+
+		/**
+		 * \brief Count the solutions of the grid
+		 *
+		 * The method throws a SudokuException if the number of solutions does not fit in a count_t.
+		 * \return Number of solutions
+		 */
+		count_t count();
+
+		/**
+		 * \brief Draw a solution uniformly at random
+		 *
+		 * Each solution of the grid is drawn with the same probability. The numbers of solutions are kept in the cache between two calls. The method throws a SudokuException if the number of solutions does not fit in a count_t.
+		 * \param generator Random generator
+		 * \param values Vector receiving the values of the cells of the solution, row by row
+		 * \return False if the grid has no solution
+		 */
+		bool sample(std::mt19937 &generator,std::vector<elem_t> &values);
+
+		size_t nbranches() const {return _nbranches;}	//!< Number of branches tried during the last count
+		size_t nsplits() const {return _nsplits;}	//!< Number of times the remaining cells were split in several components
+		size_t nhits() const {return _nhits;}	//!< Number of components whose count was found in the cache
+
+	private:
+		/**
+		 * \brief Hash function of the keys of the cache
+		 */
+		struct KeyHash {
+			size_t operator()(const std::vector<uint64_t> &key) const;
+		};
+
+		std::shared_ptr<const Geometry> _geometry;	//!< Geometry of the grid
+		std::vector<uint64_t> _masks;	//!< Possible values of each cell, as a bit mask, 0 for the cells holding a value
+		std::vector<size_t> _empty;	//!< Empty cells of the grid
+		std::vector<elem_t> _values;	//!< Values of the cells of the grid, 0 for the empty cells
+		std::vector<size_t> _mark;	//!< Mark of the cells of the current component
+		std::vector<size_t> _unitmark;	//!< Mark of the units already checked during a propagation
+		size_t _stamp;	//!< Last mark used
+		std::unordered_map<std::vector<uint64_t>,count_t,KeyHash> _cache;	//!< Numbers of solutions of the components already counted
+		std::unordered_map<std::vector<uint64_t>,std::vector<count_t>,KeyHash> _weights;	//!< Numbers of solutions of each value of the branching cell of the components already drawn, indexed by the renumbered values
+		size_t _maxentries;	//!< Number of entries of the cache above which it is cleared
+		bool _weighing;	//!< Tell if the counts of the values of the branching cells are stored in ModelCounter::_weights while counting
+		size_t _nbranches;	//!< Number of branches tried
+		size_t _nsplits;	//!< Number of splits in components
+		size_t _nhits;	//!< Number of cache hits
+
+		/**
+		 * \brief Count the solutions of a set of cells
+		 *
+		 * The possible values of the cells of the set must not intersect the possible values of their peers outside of the set. The masks of the cells are restored before the method returns.
+		 * \param cells Empty cells of the set
+		 * \return Number of ways to fill the cells
+		 */
+		count_t count(std::vector<size_t> cells);
+
+		/**
+		 * \brief Draw a way to fill a set of cells uniformly at random
+		 *
+		 * The set must satisfy the same condition as in ModelCounter::count, and have at least one way to be filled. The masks of the cells are restored before the method returns.
+		 * \param cells Empty cells of the set
+		 * \param generator Random generator
+		 * \param values Vector receiving the values of the cells of the set
+		 */
+		void sample(std::vector<size_t> cells,std::mt19937 &generator,std::vector<elem_t> &values);
+
+		/**
+		 * \brief Propagate the singles in a set of cells
+		 *
+		 * The cells which receive a value are removed from the set.
+		 * \param cells Empty cells of the set
+		 * \return False if a contradiction has been found
+		 */
+		bool propagate(std::vector<size_t> &cells);
+
+		/**
+		 * \brief Split a set of cells in independent components
+		 *
+		 * \param cells Empty cells of the set
+		 * \return Components of the set, the cells of each component being sorted
+		 */
+		std::vector<std::vector<size_t> > split(const std::vector<size_t> &cells);
+
+		/**
+		 * \brief Key of a component in the cache
+		 *
+		 * \param cells Sorted cells of the component
+		 * \param labels If the pointer is not null, array of 64 integers receiving the new number of each value, or -1 for the values absent from the component
+		 * \return Key made of the index and the renumbered possible values of each cell
+		 */
+		std::vector<uint64_t> key(const std::vector<size_t> &cells,int *labels=0) const;
+};
+
+#endif   /* ----- #ifndef COUNT_INC  ----- */
@@ -0,0 +1,160 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  driver.cpp
+ *
+ *    Description:  Implementation of the scripted driver of the interactive interface
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 00:51:27
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include "driver.h"
+#include "objects.h"
+
+using namespace std;
+
+std::vector<ScriptDriver::Action> ScriptDriver::read_script(std::istream &in) {
+	static const char *names[5][2]={{"<Left>","\033OD"},{"<Right>","\033OC"},{"<Up>","\033OA"},{"<Down>","\033OB"},{"<Del>","\033[3~"}};
+	vector<Action> script;
+	string line;
+	while (getline(in,line)) {
+		if (line.empty() || line[0]=='#') continue;
+		size_t tab=line.find('\t');
+		if (tab==string::npos) throw SudokuException(SudokuException::FORMAT_ERROR,"Missing tabulation in the line of script \""+line+"\".");
+		Action action;
+		action.label=line.substr(0,tab);
+		for (size_t i=tab+1;i<line.size();++i) {
+			if (line[i]=='<') {
+				size_t k=0;
+				while (k<5 && line.compare(i,strlen(names[k][0]),names[k][0])!=0) ++k;
+				if (k<5) {
+					action.keys+=names[k][1];
+					i+=strlen(names[k][0])-1;
+					continue;
+				}
+			}
+			if (line[i]!='\\' || i+1==line.size()) {
+				action.keys+=line[i];
+				continue;
+			}
+			switch (line[++i]) {
+				case 'e':
+					action.keys+='\033';
+					break;
+				case 'n':
+					action.keys+='\n';
+					break;
+				case 't':
+					action.keys+='\t';
+					break;
+				case 'x':
+					if (i+2>=line.size()) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid escape in the line of script \""+line+"\".");
+					action.keys+=(char)strtol(line.substr(i+1,2).c_str(),0,16);
+					i+=2;
+					break;
+				default:
+					action.keys+=line[i];
+			}
+		}
+		script.push_back(action);
+	}
+	return script;
+}
+
+bool ScriptDriver::drain(int fd,std::chrono::steady_clock::time_point start,Measure &measure) const {
+	char buf[4096];
+	measure.first=0;
+	measure.frame=0;
+	measure.latency=0;
+	measure.bytes=0;
+	bool framed=false;	// Tell if the first frame has ended
+	chrono::steady_clock::time_point last=start;
+	while (true) {
+		// The silences are counted from the last byte read, a short one ends the first frame and a long one the action
+		double limit=(measure.bytes>0 && !framed)?_gap:_quiet;
+		double waited=chrono::duration<double>(chrono::steady_clock::now()-last).count();
+		pollfd p={fd,POLLIN,0};
+		int r=poll(&p,1,(limit>waited)?(int)((limit-waited)*1000):0);
+		if (r<0 && errno==EINTR) continue;
+		if (r<=0) {
+			if (measure.bytes==0 || framed) return true;
+			framed=true;
+			continue;
+		}
+		ssize_t n=read(fd,buf,sizeof(buf));
+		if (n<=0) return false;	// The slave side has been closed by the program
+		last=chrono::steady_clock::now();
+		double elapsed=chrono::duration<double>(last-start).count();
+		if (measure.bytes==0) measure.first=elapsed;
+		if (!framed) measure.frame=elapsed;
+		measure.latency=elapsed;
+		measure.bytes+=n;
+	}
+}
+
+std::vector<ScriptDriver::Measure> ScriptDriver::run(const std::vector<Action> &script) {
+	int master=posix_openpt(O_RDWR | O_NOCTTY);
+	if (master<0 || grantpt(master)!=0 || unlockpt(master)!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to create a pseudo-terminal.");
+	string slave=ptsname(master);
+	winsize ws;
+	memset(&ws,0,sizeof(ws));
+	ws.ws_row=_rows;
+	ws.ws_col=_columns;
+	ioctl(master,TIOCSWINSZ,&ws);
+	cout.flush();
+	cerr.flush();
+	auto start=chrono::steady_clock::now();
+	pid_t pid=fork();
+	if (pid<0) throw SudokuException(SudokuException::IO_ERROR,"Unable to start the program.");
+	if (pid==0) {
+		// Child process, the program runs on the slave side of the terminal
+		close(master);
+		setsid();
+		int fd=open(slave.c_str(),O_RDWR);
+		if (fd<0) _exit(1);
+		ioctl(fd,TIOCSCTTY,0);
+		dup2(fd,0);
+		dup2(fd,1);
+		dup2(fd,2);
+		if (fd>2) close(fd);
+		setenv("TERM","xterm",1);
+		setenv("LC_ALL","C.UTF-8",1);
+		_program();
+		_exit(0);
+	}
+	vector<Measure> measures;
+	Measure m;
+	m.label="start";
+	bool alive=drain(master,start,m);
+	measures.push_back(m);
+	for (size_t i=0;i<script.size() && alive;++i) {
+		m.label=script[i].label;
+		start=chrono::steady_clock::now();
+		if (write(master,script[i].keys.data(),script[i].keys.size())!=(ssize_t)script[i].keys.size()) break;
+		alive=drain(master,start,m);
+		measures.push_back(m);
+	}
+	if (alive) kill(pid,SIGTERM);
+	waitpid(pid,0,0);
+	close(master);
+	return measures;
+}
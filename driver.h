@@ -0,0 +1,102 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  driver.h
+ *
+ *    Description:  Definition of the scripted driver of the interactive interface
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 00:34:10
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  DRIVER_INC
+#define  DRIVER_INC
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <functional>
+#include <chrono>
+
+/**
+ * \brief Driver replaying key scripts on an interactive program
+ *
+ * The driver runs a program in a child process attached to a pseudo-terminal, with a fixed size, the terminal type xterm and a UTF-8 locale so that the measures can be repeated. It sends the keys of each action of a script to the terminal and reads what the program writes back until the terminal stays quiet for a while. For each action, it measures the time between the keys and the first byte written by the program, the time until the end of the first frame, which is the first burst of output followed by a short silence, and the time until the last byte before the terminal stays quiet, as well as the number of bytes written. The first frame is the answer of the program to the keys, while the last byte also counts the screens redrawn periodically by the program, such as the spinner of a background generation, which may go on long after the keys have been handled.
+ * A script is a text with one action per line, made of a label, a tabulation and the keys of the action. The keys are written as text with the escapes \\e (Escape), \\n (Enter), \\t, \\\\ and \\xHH, and the names <Left>, <Right>, <Up>, <Down> and <Del> for the keys sending escape sequences (the arrows are sent in the application mode of xterm, which is set by the keypad mode of Ncurses). Empty lines and lines starting with # are ignored. As the Escape key is only recognized after a delay, it must be alone in its action.
+ */
+class ScriptDriver {
+	public:
+		/**
+		 * \brief Action of a script
+		 */
+		struct Action {
+			std::string label;	//!< Label of the action in the measures
+			std::string keys;	//!< Bytes sent to the terminal
+		};
+
+		/**
+		 * \brief Measure of an action
+		 */
+		struct Measure {
+			std::string label;	//!< Label of the action
+			double first;	//!< Time in seconds between the keys and the first byte written by the program, 0 if nothing was written
+			double frame;	//!< Time in seconds between the keys and the end of the first frame written by the program, 0 if nothing was written
+			double latency;	//!< Time in seconds between the keys and the last byte written by the program before it stays quiet
+			size_t bytes;	//!< Number of bytes written by the program
+		};
+
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param pprogram Function run in the child process, on the pseudo-terminal
+		 * \param prows Number of rows of the terminal
+		 * \param pcolumns Number of columns of the terminal
+		 * \param pquiet Number of seconds without output after which an action is considered done
+		 * \param pgap Number of seconds without output ending a frame, it must be shorter than the period of the screens redrawn by the program
+		 */
+		ScriptDriver(std::function<void()> pprogram,unsigned short prows=50,unsigned short pcolumns=120,double pquiet=0.25,double pgap=0.02):_program(pprogram),_rows(prows),_columns(pcolumns),_quiet(pquiet),_gap(pgap) {}
+
+		/**
+		 * \brief Read a script
+		 *
+		 * The method throws a SudokuException if a line is not valid.
+		 * \param in Input stream holding the script
+		 * \return Actions of the script
+		 */
+		static std::vector<Action> read_script(std::istream &in);
+
+		/**
+		 * \brief Run a script
+		 *
+		 * The first measure, labelled "start", is the start of the program before the first action. The program is killed if it is still running at the end of the script. The method throws a SudokuException if the pseudo-terminal can not be created.
+		 * \param script Actions to replay
+		 * \return Measures of the actions, in the order of the script
+		 */
+		std::vector<Measure> run(const std::vector<Action> &script);
+
+	private:
+		std::function<void()> _program;	//!< Function run in the child process
+		unsigned short _rows;	//!< Number of rows of the terminal
+		unsigned short _columns;	//!< Number of columns of the terminal
+		double _quiet;	//!< Number of seconds without output ending an action
+		double _gap;	//!< Number of seconds without output ending a frame
+
+		/**
+		 * \brief Read the output of the program until it stays quiet
+		 *
+		 * \param fd File descriptor of the master side of the pseudo-terminal
+		 * \param start Time when the action started
+		 * \param measure Measure of the action, updated with the times and the number of bytes
+		 * \return False if the program has closed the terminal
+		 */
+		bool drain(int fd,std::chrono::steady_clock::time_point start,Measure &measure) const;
+};
+
+#endif   /* ----- #ifndef DRIVER_INC  ----- */
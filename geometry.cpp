@@ -0,0 +1,200 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  geometry.cpp
+ *
+ *    Description:  Implementation of the precomputed tables describing the sets of a grid
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 14:20:36
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include "geometry.h"
+#include "objects.h"
+
+using namespace std;
+
+shared_ptr<const Geometry> Geometry::rectangular(size_t rows,size_t columns,bool diagonals) {
+	static map<tuple<size_t,size_t,bool>,shared_ptr<const Geometry> > cache;
+	static mutex cachemutex;
+	lock_guard<mutex> lock(cachemutex);
+	shared_ptr<const Geometry> &g=cache[make_tuple(rows,columns,diagonals)];
+	if (!g) {
+		size_t d2=rows*columns;
+		vector<size_t> regions(d2*d2);
+		for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) regions[i*d2+j]=(i/rows)*rows+j/columns;
+		g=make_shared<Geometry>(d2,regions,diagonals,rows,columns);
+	}
+	return g;
+}
+
+shared_ptr<const Geometry> Geometry::jigsaw(size_t dim2,const vector<size_t> &regions,bool diagonals) {
+	if (dim2==0 || regions.size()!=dim2*dim2) throw SudokuException(SudokuException::FORMAT_ERROR,"The regions must cover the whole grid.");
+	vector<size_t> count(dim2,0);
+	for (size_t r:regions) {
+		if (r>=dim2) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid region number.");
+		++count[r];
+	}
+	for (size_t n:count) if (n!=dim2) throw SudokuException(SudokuException::FORMAT_ERROR,"Each region must hold as many cells as a row.");
+	return make_shared<Geometry>(dim2,regions,diagonals);
+}
+
+shared_ptr<const Geometry> Geometry::read_regions(istream &in,bool diagonals) {
+	vector<size_t> regions;
+	string line;
+	size_t num;
+	getline(in,line);
+	istringstream iss(line);
+	while (iss >> num) regions.push_back(num-1);
+	size_t d2=regions.size();
+	for (size_t i=1;i<d2;++i) {
+		getline(in,line);
+		iss.clear();
+		iss.str(line);
+		for (size_t j=0;j<d2;++j) {
+			if (!(iss >> num)) throw SudokuException(SudokuException::FORMAT_ERROR,"Incomplete row of regions.");
+			regions.push_back(num-1);
+		}
+	}
+	return jigsaw(d2,regions,diagonals);
+}
+
+shared_ptr<const Geometry> Geometry::killer(const Geometry &base,const vector<size_t> &cages,const vector<size_t> &sums) {
+	size_t d2=base.dim2();
+	if (d2>9) throw SudokuException(SudokuException::FORMAT_ERROR,"Cages are only supported for grids of at most 9 values.");
+	if (cages.size()!=d2*d2) throw SudokuException(SudokuException::FORMAT_ERROR,"The cages must be given for the whole grid.");
+	vector<size_t> count(sums.size(),0);
+	for (size_t k:cages) if (k!=nocage) {
+		if (k>=sums.size()) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid cage number.");
+		++count[k];
+	}
+	for (size_t k=0;k<sums.size();++k) {
+		if (count[k]==0 || count[k]>d2) throw SudokuException(SudokuException::FORMAT_ERROR,"Each cage must hold between 1 cell and as many cells as a row.");
+		if (cage_mask(count[k],sums[k],(1u<<d2)-1)==0) throw SudokuException(SudokuException::FORMAT_ERROR,"The sum of a cage cannot be reached.");
+	}
+	vector<size_t> regions(d2*d2);
+	for (size_t c=0;c<d2*d2;++c) regions[c]=base.region(c);
+	return make_shared<Geometry>(d2,regions,base.diagonals(),base.box_rows(),base.box_columns(),cages,sums);
+}
+
+shared_ptr<const Geometry> Geometry::read_cages(istream &in,const Geometry &base) {
+	size_t d2=base.dim2();
+	vector<size_t> cages(d2*d2);
+	size_t num,ncages=0;
+	string line;
+	istringstream iss;
+	for (size_t i=0;i<d2;++i) {
+		getline(in,line);
+		iss.clear();
+		iss.str(line);
+		for (size_t j=0;j<d2;++j) {
+			if (!(iss >> num)) throw SudokuException(SudokuException::FORMAT_ERROR,"Incomplete row of cages.");
+			cages[i*d2+j]=(num==0)?nocage:num-1;
+			ncages=max(ncages,num);
+		}
+	}
+	vector<size_t> sums;
+	getline(in,line);
+	iss.clear();
+	iss.str(line);
+	while (iss >> num) sums.push_back(num);
+	if (sums.size()!=ncages) throw SudokuException(SudokuException::FORMAT_ERROR,"The line of sums must give the sum of each cage.");
+	return killer(base,cages,sums);
+}
+
+unsigned Geometry::cage_mask(size_t size,size_t sum,unsigned candidates) {
+	// Table indexed by the number of cells, the sum and the candidates, for the values 1 to 9
+	static const size_t maxsum=45;
+	static const vector<unsigned short> table=[]() {
+		vector<unsigned short> t(10*(maxsum+1)*512,0);
+		for (unsigned set=0;set<512;++set) {
+			size_t n=0,s=0;
+			for (size_t v=1;v<=9;++v) if (set & (1u<<(v-1))) {
+				++n;
+				s+=v;
+			}
+			// The set is allowed for all its supersets of candidates
+			unsigned others=511 & ~set;
+			unsigned extra=others;
+			while (true) {
+				t[(n*(maxsum+1)+s)*512+(set | extra)]|=set;
+				if (extra==0) break;
+				extra=(extra-1) & others;
+			}
+		}
+		return t;
+	}();
+	if (size>9 || sum>maxsum) return 0;
+	return table[(size*(maxsum+1)+sum)*512+(candidates & 511)];
+}
+
+Geometry::Geometry(size_t pdim2,const vector<size_t> &pregions,bool pdiagonals,size_t pboxrows,size_t pboxcolumns,const vector<size_t> &pcages,const vector<size_t> &psums):_dim((size_t)sqrt((double)pdim2+0.5)),_dim2(pdim2),_diagonals(pdiagonals),_boxrows(pboxrows),_boxcolumns(pboxcolumns),_unitcells(nunits()*pdim2),_cellcages(pcages),_cagesums(psums) {
+	// Units, in the order rows, columns, regions, diagonals
+	vector<size_t> filled(_dim2,0);
+	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) {
+		size_t c=i*_dim2+j;
+		_unitcells[i*_dim2+j]=c;
+		_unitcells[(_dim2+j)*_dim2+i]=c;
+		size_t r=pregions[c];
+		_unitcells[(2*_dim2+r)*_dim2+(filled[r]++)]=c;
+	}
+	if (_diagonals) for (size_t i=0;i<_dim2;++i) {
+		_unitcells[(3*_dim2)*_dim2+i]=i*_dim2+i;
+		_unitcells[(3*_dim2+1)*_dim2+i]=i*_dim2+_dim2-1-i;
+	}
+	// Units of each cell, as lists stored one after the other. Units are scanned in increasing order, so the order row, column, region, diagonals is kept.
+	vector<vector<pair<size_t,size_t> > > lists(ncells());
+	for (size_t u=0;u<nunits();++u) for (size_t i=0;i<_dim2;++i) lists[unit(u)[i]].push_back(make_pair(u,i));
+	_celloffsets.push_back(0);
+	for (size_t c=0;c<ncells();++c) {
+		for (auto &p:lists[c]) {
+			_cellunits.push_back(p.first);
+			_cellpositions.push_back(p.second);
+		}
+		_celloffsets.push_back(_cellunits.size());
+	}
+	// Cells of each cage, as lists stored one after the other
+	_cageoffsets.assign(ncages()+1,0);
+	for (size_t k:_cellcages) if (k!=nocage) ++_cageoffsets[k+1];
+	for (size_t k=0;k<ncages();++k) _cageoffsets[k+1]+=_cageoffsets[k];
+	_cagecells.resize(_cageoffsets.back());
+	vector<size_t> next(_cageoffsets);
+	for (size_t c=0;c<_cellcages.size();++c) if (_cellcages[c]!=nocage) _cagecells[next[_cellcages[c]]++]=c;
+	// Peers, each cell of the units and of the cage of the cell except itself, without duplicates
+	vector<bool> seen(ncells(),false);
+	_peeroffsets.push_back(0);
+	for (size_t c=0;c<ncells();++c) {
+		seen[c]=true;
+		for (size_t t=0;t<degree(c);++t) for (size_t i=0;i<_dim2;++i) {
+			size_t p=unit(units(c)[t])[i];
+			if (!seen[p]) {
+				seen[p]=true;
+				_peers.push_back(p);
+			}
+		}
+		if (cage_of(c)!=nocage) for (size_t i=0;i<cage_size(cage_of(c));++i) {
+			size_t p=cage(cage_of(c))[i];
+			if (!seen[p]) {
+				seen[p]=true;
+				_peers.push_back(p);
+			}
+		}
+		seen[c]=false;
+		for (size_t i=_peeroffsets.back();i<_peers.size();++i) seen[_peers[i]]=false;
+		_peeroffsets.push_back(_peers.size());
+	}
+}
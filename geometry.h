@@ -0,0 +1,215 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  geometry.h
+ *
+ *    Description:  Definition of the precomputed tables describing the sets of a grid
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 14:02:51
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  GEOMETRY_INC
+#define  GEOMETRY_INC
+
+#include <vector>
+#include <memory>
+#include <istream>
+
+/**
+ * \brief Geometry of a Sudoku grid
+ *
+ * The class holds the tables describing the sets (or units) of a grid: the cells of each unit, the units of each cell and the peers of each cell. Cells are numbered row by row, so that the cell (row,column) has index row*dim2+column.
+ * Every unit holds exactly dim2 cells, which must all have different values. The units are the rows, the columns, the regions and optionally the two main diagonals. The regions are the inner squares of a standard grid, the rectangular boxes of grids like 6x6 (boxes of 2x3 cells) or 12x12 (boxes of 3x4 cells), or any partition of the grid in dim2 regions of dim2 cells for jigsaw grids.
+ * Units are numbered by type, then by index of set: unit type*dim2+set is the set (type,set) in the Sudoku base, see Grid::SuCoordinates. The types are 0 for rows, 1 for columns, 2 for regions and 3 for diagonals (set 0 is the diagonal from the top-left corner, set 1 the one from the top-right corner). The cells of a unit are listed in the order of their index in the set, which is row by row for regions and diagonals.
+ * A geometry may also hold killer cages: groups of cells whose values must be different and add up to a given sum. The cells of a cage are peers of each other, but a cage is not a unit since it does not hold all the values. Cages are only supported for grids of at most 9 values.
+ * The tables are built once and shared by all the grids with the same geometry.
+ */
+class Geometry {
+	public:
+		/**
+		 * \brief Get the geometry of a standard grid
+		 *
+		 * This static method returns the geometry of the standard grid of the given dimension, with rows, columns and inner squares. The geometry is built on the first call and shared afterwards.
+		 * \param dim Dimension of the grid (number of cells on one row of an inner square)
+		 * \param diagonals Tell if the two main diagonals are units too (X-Sudoku), default is false
+		 * \return Shared geometry
+		 */
+		static std::shared_ptr<const Geometry> standard(size_t dim,bool diagonals=false) {return rectangular(dim,dim,diagonals);}
+
+		/**
+		 * \brief Get the geometry of a grid with rectangular boxes
+		 *
+		 * This static method returns the geometry of a grid whose regions are boxes of rows*columns cells. The grid has rows*columns rows and columns. The geometry is built on the first call and shared afterwards.
+		 * \param rows Number of rows of a box
+		 * \param columns Number of columns of a box
+		 * \param diagonals Tell if the two main diagonals are units too, default is false
+		 * \return Shared geometry
+		 */
+		static std::shared_ptr<const Geometry> rectangular(size_t rows,size_t columns,bool diagonals=false);
+
+		/**
+		 * \brief Get the geometry of a jigsaw grid
+		 *
+		 * This static method builds the geometry of a grid whose regions are given cell by cell. It throws a SudokuException if the regions do not form a partition of the grid in dim2 regions of dim2 cells.
+		 * \param dim2 Number of rows (or columns) of the grid
+		 * \param regions Index of the region of each cell, from 0 to dim2-1, row by row
+		 * \param diagonals Tell if the two main diagonals are units too, default is false
+		 * \return New geometry
+		 */
+		static std::shared_ptr<const Geometry> jigsaw(size_t dim2,const std::vector<size_t> &regions,bool diagonals=false);
+
+		/**
+		 * \brief Read the regions of a jigsaw grid from a stream
+		 *
+		 * The stream has the same format as the one of Grid::read_from_stream: each line holds one row of the grid, and the elements in columns are separated by whitespaces. Each element is the number of the region of the cell, from 1 to dim2. The dimension is detected by the number of elements in the first line.
+		 * \param in Input stream
+		 * \param diagonals Tell if the two main diagonals are units too, default is false
+		 * \return New geometry
+		 */
+		static std::shared_ptr<const Geometry> read_regions(std::istream &in,bool diagonals=false);
+
+		/**
+		 * \brief Get the geometry of a killer grid
+		 *
+		 * This static method adds cages to the units of a geometry. It throws a SudokuException if the grid has more than 9 values, if a cage is empty or larger than a row, or if no set of different values of a cage gives its sum.
+		 * \param base Geometry giving the units of the grid
+		 * \param cages Index of the cage of each cell, from 0 to the number of cages minus 1, or Geometry::nocage for a cell outside any cage, row by row
+		 * \param sums Sum of the values of each cage
+		 * \return New geometry
+		 */
+		static std::shared_ptr<const Geometry> killer(const Geometry &base,const std::vector<size_t> &cages,const std::vector<size_t> &sums);
+
+		/**
+		 * \brief Read the cages of a killer grid from a stream
+		 *
+		 * The first lines of the stream have the format of Geometry::read_regions, each element being the number of the cage of the cell, from 1, or 0 for a cell outside any cage. The next line holds the sums of the cages, in the order of their numbers.
+		 * \param in Input stream
+		 * \param base Geometry giving the units of the grid
+		 * \return New geometry
+		 */
+		static std::shared_ptr<const Geometry> read_cages(std::istream &in,const Geometry &base);
+
+		/**
+		 * \brief Values allowed in a cage
+		 *
+		 * This static method looks up a table built on the first call, which gives for each number of cells, sum and set of candidates the union of the sets of different values taken among the candidates, with this number of values, whose sum is right. Value v is bit v-1 of the sets.
+		 * \param size Number of empty cells of the cage
+		 * \param sum Sum of the values of the empty cells
+		 * \param candidates Union of the possible values of the empty cells
+		 * \return Set of the values which can be placed in the empty cells, 0 if there is none
+		 */
+		static unsigned cage_mask(size_t size,size_t sum,unsigned candidates);
+
+		static const size_t nocage=(size_t)-1;	//!< Cage of a cell outside any cage
+
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor builds the tables of a grid from the regions of its cells. Use the static methods to get a shared instance instead.
+		 * \param pdim2 Number of rows (or columns) of the grid
+		 * \param pregions Index of the region of each cell, from 0 to pdim2-1, row by row. Each region must hold pdim2 cells.
+		 * \param pdiagonals Tell if the two main diagonals are units too
+		 * \param pboxrows Number of rows of a box if the regions are rectangular boxes, 0 otherwise
+		 * \param pboxcolumns Number of columns of a box if the regions are rectangular boxes, 0 otherwise
+		 * \param pcages Index of the cage of each cell, or Geometry::nocage, row by row, empty vector for a grid without cages
+		 * \param psums Sum of the values of each cage
+		 */
+		Geometry(size_t pdim2,const std::vector<size_t> &pregions,bool pdiagonals,size_t pboxrows=0,size_t pboxcolumns=0,const std::vector<size_t> &pcages=std::vector<size_t>(),const std::vector<size_t> &psums=std::vector<size_t>());
+
+		size_t dim() const {return _dim;}	//!< Nominal dimension of the grid, square root of the number of rows rounded down, used to scale the number of clues
+		size_t dim2() const {return _dim2;}	//!< Number of rows (or columns) of the grid
+		size_t ncells() const {return _dim2*_dim2;}	//!< Number of cells of the grid
+		size_t nunits() const {return _diagonals?3*_dim2+2:3*_dim2;}	//!< Number of units of the grid
+		bool diagonals() const {return _diagonals;}	//!< Tell if the two main diagonals are units
+		size_t box_rows() const {return _boxrows;}	//!< Number of rows of a box, 0 if the regions are not rectangular boxes
+		size_t box_columns() const {return _boxcolumns;}	//!< Number of columns of a box, 0 if the regions are not rectangular boxes
+		size_t ncages() const {return _cagesums.size();}	//!< Number of cages of the grid, 0 if it is not a killer grid
+		size_t cage_size(size_t cage) const {return _cageoffsets[cage+1]-_cageoffsets[cage];}	//!< Number of cells of a cage
+		size_t cage_sum(size_t cage) const {return _cagesums[cage];}	//!< Sum of the values of a cage
+		const size_t *cage(size_t cage) const {return &_cagecells[_cageoffsets[cage]];}	//!< Cells of a cage, Geometry::cage_size of them
+		size_t cage_of(size_t cell) const {return _cellcages.empty()?nocage:_cellcages[cell];}	//!< Cage of a cell, Geometry::nocage if it is outside any cage
+
+		/**
+		 * \brief Cells of a unit
+		 *
+		 * \param unit Index of the unit
+		 * \return Pointer to the array of the Geometry::dim2 indexes of the cells of the unit
+		 */
+		const size_t *unit(size_t unit) const {return &_unitcells[unit*_dim2];}
+
+		/**
+		 * \brief Units of a cell
+		 *
+		 * \param cell Index of the cell
+		 * \return Pointer to the array of the Geometry::degree indexes of the units containing the cell, in the order row, column, region, then the diagonals holding the cell
+		 */
+		const size_t *units(size_t cell) const {return &_cellunits[_celloffsets[cell]];}
+
+		/**
+		 * \brief Positions of a cell in its units
+		 *
+		 * \param cell Index of the cell
+		 * \return Pointer to the array of the Geometry::degree indexes of the cell in each of its units, in the same order as Geometry::units
+		 */
+		const size_t *positions(size_t cell) const {return &_cellpositions[_celloffsets[cell]];}
+
+		/**
+		 * \brief Number of units of a cell
+		 *
+		 * \param cell Index of the cell
+		 * \return Number of units containing the cell, 3 for a standard grid
+		 */
+		size_t degree(size_t cell) const {return _celloffsets[cell+1]-_celloffsets[cell];}
+
+		/**
+		 * \brief Region of a cell
+		 *
+		 * \param cell Index of the cell
+		 * \return Index of the region containing the cell, from 0 to Geometry::dim2-1
+		 */
+		size_t region(size_t cell) const {return _cellunits[_celloffsets[cell]+2]-2*_dim2;}
+
+		/**
+		 * \brief Peers of a cell
+		 *
+		 * The peers of a cell are the other cells sharing at least one unit with it. Each peer is listed once.
+		 * \param cell Index of the cell
+		 * \return Pointer to the array of the Geometry::npeers indexes of the peers of the cell
+		 */
+		const size_t *peers(size_t cell) const {return &_peers[_peeroffsets[cell]];}
+
+		/**
+		 * \brief Number of peers of a cell
+		 *
+		 * \param cell Index of the cell
+		 * \return Number of peers of the cell, the same for all cells of a standard grid
+		 */
+		size_t npeers(size_t cell) const {return _peeroffsets[cell+1]-_peeroffsets[cell];}
+
+	private:
+		size_t _dim;	//!< Nominal dimension of the grid
+		size_t _dim2;	//!< Number of rows (or columns) of the grid
+		bool _diagonals;	//!< Tell if the two main diagonals are units
+		size_t _boxrows;	//!< Number of rows of a box, 0 for jigsaw regions
+		size_t _boxcolumns;	//!< Number of columns of a box, 0 for jigsaw regions
+		std::vector<size_t> _unitcells;	//!< Cells of each unit, Geometry::dim2 entries for each unit
+		std::vector<size_t> _celloffsets;	//!< Offset of the first unit of each cell in Geometry::_cellunits, with one more entry for the end of the table
+		std::vector<size_t> _cellunits;	//!< Units of each cell
+		std::vector<size_t> _cellpositions;	//!< Position of each cell in its units
+		std::vector<size_t> _peeroffsets;	//!< Offset of the first peer of each cell in Geometry::_peers, with one more entry for the end of the table
+		std::vector<size_t> _peers;	//!< Peers of each cell
+		std::vector<size_t> _cellcages;	//!< Cage of each cell, empty if the grid has no cage
+		std::vector<size_t> _cageoffsets;	//!< Offset of the first cell of each cage in Geometry::_cagecells, with one more entry for the end of the table
+		std::vector<size_t> _cagecells;	//!< Cells of each cage
+		std::vector<size_t> _cagesums;	//!< Sum of each cage
+};
+
+#endif   /* ----- #ifndef GEOMETRY_INC  ----- */
@@ -22,57 +22,109 @@
 #include <utility>
 #include <ctype.h>
 #include <wchar.h>
+#include <chrono>
 #include "gui_curses.h"
 
 using namespace std;
 
+void CursesGui::new_game(size_t dimension,size_t difficulty) {
+	waiting=false;
+	if ((bank==0 || !bank->draw(dimension,difficulty,maingrid,&solution)) && !generator.take(dimension,difficulty,maingrid,solution)) {
+		// Play on an empty grid until the puzzle is generated
+		waiting=true;
+		wdimension=dimension;
+		wdifficulty=difficulty;
+		wstart=chrono::steady_clock::now();
+		generator.request(dimension,difficulty);
+		maingrid=Grid(dimension);
+		solution=Grid();
+	}
+	show_game();
+}
+
+void CursesGui::show_game() {
+	history.clear();
+	session.reset(maingrid);
+	reset_conflicts();
+	draw_structure(maingrid);
+	si=0;sj=0;
+	for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) draw_element(maingrid,i,j);
+}
+
+void CursesGui::poll_generator() {
+	static const char spinner[4]={'|','/','-','\\'};
+	if (generator.take(wdimension,wdifficulty,maingrid,solution)) {
+		waiting=false;
+		show_game();
+		move(ymax-1,0);
+		clrtoeol();
+		return;
+	}
+	size_t elapsed=chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-wstart).count();
+	mvprintw(ymax-1,0,"%c Generating a new grid (%lu.%lus), Esc to cancel",spinner[elapsed/100%4],elapsed/1000,elapsed/100%10);
+	clrtoeol();
+}
+
+void CursesGui::set_cell(size_t row,size_t column,elem_t value) {
+	elem_t old=maingrid(row,column)->value;
+	if (old==value) return;
+	vector<Grid::XYCoordinates> peers=maingrid.peers(row,column);
+	if (old!=0) {
+		for (auto xy:peers) if (maingrid(xy.row,xy.column)->value==old && --nconflicts[xy.row*maingrid.dim2()+xy.column]==0) draw_element(maingrid,xy.row,xy.column);
+		maingrid.unset_value(row,column);
+	}
+	nconflicts[row*maingrid.dim2()+column]=0;
+	if (value!=0) {
+		maingrid.set_value(row,column,value);
+		for (auto xy:peers) if (maingrid(xy.row,xy.column)->value==value) {
+			nconflicts[row*maingrid.dim2()+column]++;
+			if (nconflicts[xy.row*maingrid.dim2()+xy.column]++==0) draw_element(maingrid,xy.row,xy.column);
+		}
+	}
+	session.assign(row,column,value);
+	draw_element(maingrid,row,column);
+}
+
+void CursesGui::remember(const vector<Grid::XYCoordinates> &cells) {
+	vector<change> move;
+	move.reserve(cells.size());
+	for (auto xy:cells) move.push_back({xy.row,xy.column,maingrid(xy.row,xy.column)->value});
+	history.push_back(std::move(move));
+	if (history.size()>max_history) history.pop_front();
+}
+
+void CursesGui::reset_conflicts() {
+	nconflicts.assign(maingrid.dim2()*maingrid.dim2(),0);
+	for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) nconflicts[i*maingrid.dim2()+j]=maingrid.conflicts(i,j);
+}
+
 void CursesGui::draw_structure(const Grid &grid) {
+	// Junctions inside the grid, indexed by the thick arms: 1 for up, 2 for down, 4 for left, 8 for right
+	static const wchar_t *crosses[16]={L"┼",L"╀",L"╁",L"╂",L"┽",L"╃",L"╅",L"╉",L"┾",L"╄",L"╆",L"╊",L"┿",L"╇",L"╈",L"╋"};
+	const Geometry &geometry=grid.geometry();
+	size_t d2=grid.dim2();
+	// A border is thick on the edges of the grid and between cells of different regions
+	auto vthick=[&](size_t i,size_t k) {return k==0 || k==d2 || geometry.region(i*d2+k-1)!=geometry.region(i*d2+k);};	// Border on the left of column k in row i
+	auto hthick=[&](size_t i,size_t j) {return i==0 || i==d2 || geometry.region((i-1)*d2+j)!=geometry.region(i*d2+j);};	// Border above row i in column j
 	move(0,0);
 	clrtobot();
 	size_t sx;
-	xspace=(grid.dim()<=3)?1:0;
-	xmin=(xmax-grid.dim2()*2*(1+xspace)-1)/2;
-	mvaddwstr(0,xmin,L"┏");
+	xspace=(d2<=9)?1:0;
+	xmin=(xmax-d2*2*(1+xspace)-1)/2;
 	sx=2*xspace+1;
-	for (size_t j=0;j<grid.dim2();++j) {
-		for (size_t k=0;k<sx;++k) addwstr(L"━");
-		if (j==grid.dim2()-1) addwstr(L"┓"); else {
-			if ((j+1) % grid.dim()==0) addwstr(L"┳"); else addwstr(L"┯");
-		}
-	}
-	for (size_t i=0;i<grid.dim2();++i) {
-		for (size_t j=1;j<=sx;++j) 
-			for (size_t k=0;k<=grid.dim2();++k) {
-				if (k % grid.dim()==0) mvaddwstr(i*(sx+1)+j,xmin+k*(sx+1),L"┃");
-				else mvaddwstr(i*(sx+1)+j,xmin+k*(sx+1),L"│");
-			}
-		if (i==grid.dim2()-1) {
-			mvaddwstr((i+1)*(sx+1),xmin,L"┗");
-			for (size_t j=0;j<grid.dim2();++j) {
-				for (size_t k=0;k<sx;++k) addwstr(L"━");
-				if (j==grid.dim2()-1) addwstr(L"┛"); else {
-					if ((j+1) % grid.dim()==0) addwstr(L"┻"); else addwstr(L"┷");
-				}
-			}
-		} else {
-			if ((i+1) % grid.dim()==0) {
-				mvaddwstr((i+1)*(sx+1),xmin,L"┣"); 
-				for (size_t j=0;j<grid.dim2();++j) {
-					for (size_t k=0;k<sx;++k) addwstr(L"━");
-					if (j==grid.dim2()-1) addwstr(L"┫"); else {
-						if ((j+1) % grid.dim()==0) addwstr(L"╋"); else addwstr(L"┿");
-					}
-				}
-			} else {
-				mvaddwstr((i+1)*(sx+1),xmin,L"┠");
-				for (size_t j=0;j<grid.dim2();++j) {
-					for (size_t k=0;k<sx;++k) addwstr(L"─");
-					if (j==grid.dim2()-1) addwstr(L"┨"); else {
-						if ((j+1) % grid.dim()==0) addwstr(L"╂"); else addwstr(L"┼");
-					}
-				}
-			}
+	for (size_t i=0;i<=d2;++i) {
+		for (size_t k=0;k<=d2;++k) {
+			const wchar_t *junction;
+			if (i==0) junction=(k==0)?L"┏":(k==d2)?L"┓":(vthick(0,k)?L"┳":L"┯");
+			else if (i==d2) junction=(k==0)?L"┗":(k==d2)?L"┛":(vthick(d2-1,k)?L"┻":L"┷");
+			else if (k==0) junction=hthick(i,0)?L"┣":L"┠";
+			else if (k==d2) junction=hthick(i,d2-1)?L"┫":L"┨";
+			else junction=crosses[(vthick(i-1,k)?1:0)|(vthick(i,k)?2:0)|(hthick(i,k-1)?4:0)|(hthick(i,k)?8:0)];
+			mvaddwstr(i*(sx+1),xmin+k*(sx+1),junction);
+			if (k<d2) for (size_t j=0;j<sx;++j) addwstr(hthick(i,k)?L"━":L"─");
 		}
+		if (i<d2) for (size_t j=1;j<=sx;++j)
+			for (size_t k=0;k<=d2;++k) mvaddwstr(i*(sx+1)+j,xmin+k*(sx+1),vthick(i,k)?L"┃":L"│");
 	}
 }
 
@@ -86,7 +138,8 @@ void CursesGui::draw_element(const Grid &grid,size_t row,size_t column) {
 	int attrs=0;
 	if (row==si && column==sj && !menu_mode) {
 		if (cell->fixed) attrs=COLOR_PAIR(3); else attrs=COLOR_PAIR(1);
-	} else {
+	} else if (nconflicts[row*grid.dim2()+column]>0) attrs=COLOR_PAIR(4);
+	else {
 		if (cell->fixed) attrs=COLOR_PAIR(2); else attrs=0;
 	}
 	if (attrs!=0) attron(attrs);
@@ -148,6 +201,7 @@ void CursesGui::run() {
 	init_pair(1,COLOR_YELLOW,COLOR_BLUE);
 	init_pair(2,COLOR_RED,COLOR_BLACK);
 	init_pair(3,COLOR_RED,COLOR_BLUE);
+	init_pair(4,COLOR_WHITE,COLOR_RED);
 	// Init some variables
 	getmaxyx(stdscr,ymax,xmax);
 	size_t s=0;
@@ -156,11 +210,8 @@ void CursesGui::run() {
 		if (entry.hotkey!=0) --s;
 	}
 	if (s>=xmax) menu_spacing=2; else menu_spacing=(xmax-s)/(menu.size()-1);
-	// Generate a first grid
-	maingrid=Grid::generate(3,10,&solution);
-	draw_structure(maingrid);
-	si=0;sj=0;
-	for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) if (maingrid(i,j)->fixed) draw_element(maingrid,i,j);
+	// Start a first game, the screen is drawn immediately even if the grid has to be generated
+	new_game(3,10);
 	// Main loop
 	int selected=-1;
 	bool menu_mode=false;
@@ -170,10 +221,15 @@ void CursesGui::run() {
 	int chh;
 	size_t min;
 	size_t savi,savj;
+	elem_t value;
 	while (!quit) {
 		display_menu_line(selected);
-		// Prompt for action
+		// Prompt for action, without blocking when a grid is waited for
+		if (waiting) poll_generator();
+		timeout(waiting?100:-1);
 		ch=getch();
+		timeout(-1);
+		if (ch==ERR) continue;
 		switch (ch) {
 			case 'l':case KEY_RIGHT:
 				if (menu_mode) {
@@ -221,7 +277,12 @@ void CursesGui::run() {
 			case 27:
 				nodelay(stdscr,true);
 				chh=getch();
-				if (chh==-1) {
+				if (chh==-1 && waiting) {
+					generator.cancel();
+					waiting=false;
+					mvprintw(ymax-1,0,"Generation cancelled");
+					clrtoeol();
+				} else if (chh==-1) {
 					menu_mode=!menu_mode;
 					selected=menu_mode?0:-1;
 				}
@@ -240,13 +301,15 @@ void CursesGui::run() {
 					}
 				} else {
 					ch=toupper(ch);
-					if (ch==KEY_DC || (ch>='0' && ch<='9') || (maingrid.dim()==4 && ch>='A' && ch<='F')) {
-						Cell *cell=maingrid(si,sj);
-						if (!cell->fixed) {
-							if (ch==KEY_DC) maingrid(si,sj)->value=0;
-							else if (ch>='0' && ch<='9') maingrid(si,sj)->value=ch-'0';
-							else maingrid(si,sj)->value=ch-'A'+10;
-							draw_element(maingrid,si,sj);
+					if (!waiting && (ch==KEY_DC || (ch>='0' && ch<='9') || (ch>='A' && ch<(int)('A'+maingrid.dim2()-9)))) {
+						if (!maingrid(si,sj)->fixed) {
+							if (ch==KEY_DC) value=0;
+							else if (ch>='0' && ch<='9') value=ch-'0';
+							else value=ch-'A'+10;
+							if (value<=maingrid.dim2() && value!=maingrid(si,sj)->value) {
+								remember(vector<Grid::XYCoordinates>(1,Grid::XYCoordinates(si,sj)));
+								set_cell(si,sj,value);
+							}
 						}
 					}
 				}
@@ -256,32 +319,64 @@ void CursesGui::run() {
 			case 'q':
 				quit=true;
 				break;
-			case 's':
-				if (solution.dim()==0) {
-					solution=Grid(maingrid.dim());
-					for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) solution.set_value(i,j,maingrid(i,j)->value);
-					found=solution.fill();
-				} else found=true;
+			case 'u':
+				if (!history.empty()) {
+					// The cells of the last move get their former values back, in the reverse order
+					vector<change> move=std::move(history.back());
+					history.pop_back();
+					for (auto it=move.rbegin();it!=move.rend();++it) set_cell(it->row,it->column,it->value);
+				}
+				break;
+			case 's': {
+				if (waiting) break;	// The empty grid only holds the place of the puzzle being generated
+				// The solution of a grid entered by the user is looked for again after each move, from the state kept by the session
+				Grid solved;
+				if (solution.dim2()==0) found=session.solve(solved);
+				else {
+					solved=solution;
+					found=true;
+				}
 				if (found) {
-					maingrid=solution;
+					vector<Grid::XYCoordinates> cells;
+					for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) if (maingrid(i,j)->value!=solved(i,j)->value) cells.push_back(Grid::XYCoordinates(i,j));
+					remember(cells);
+					maingrid=std::move(solved);
+					session.reset(maingrid);
+					reset_conflicts();
 					for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) if (!maingrid(i,j)->fixed) draw_element(maingrid,i,j);
 				}
 				else mvprintw(ymax-1,0,"No solution found!");
 				break;
+			}
 			case 'c':
-				if (solution.dim()==0) {
-					solution=maingrid;
-					solution.fill();
+				if (waiting) break;
+				// Point at a wrong value, or take a value deduced from the current state of the grid, or the known solution of the cell with the fewest possible values
+				found=maingrid.hint(savi,savj,value,(solution.dim2()!=0)?&solution:0);
+				if (found && maingrid(savi,savj)->value!=0) {
+					size_t oi=si,oj=sj;
+					si=savi;
+					sj=savj;
+					draw_element(maingrid,oi,oj);
+					draw_element(maingrid,si,sj);
+					mvprintw(ymax-1,0,"This value is wrong!");
+					break;
 				}
-				min=solution.dim2();
-				for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) if (maingrid(i,j)->npossible<min && maingrid(i,j)->npossible>0) {
-					min=maingrid(i,j)->npossible;
-					savi=i;savj=j;
+				if (!found && solution.dim2()!=0) {
+					min=maingrid.dim2()+1;
+					for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) if (maingrid(i,j)->value==0 && maingrid(i,j)->npossible<min) {
+						min=maingrid(i,j)->npossible;
+						savi=i;savj=j;
+					}
+					if (min<=maingrid.dim2()) {
+						value=solution(savi,savj)->value;
+						found=true;
+					}
 				}
-				if (min<solution.dim2()) {
-					maingrid.set_value(savi,savj,solution(savi,savj)->value);
-					draw_element(maingrid,savi,savj);
+				if (found) {
+					remember(vector<Grid::XYCoordinates>(1,Grid::XYCoordinates(savi,savj)));
+					set_cell(savi,savj,value);
 				}
+				else mvprintw(ymax-1,0,"No clue available!");
 				break;
 			case 'n':
 				mvprintw(ymax-1,0,"Dimension (3 or 4) ?");
@@ -301,11 +396,15 @@ void CursesGui::run() {
 					}
 					noecho();
 				}
-				if (savi==21) maingrid=Grid(si);
-				else maingrid=Grid::generate(si,savi,&solution);
-				draw_structure(maingrid);
-				si=0;sj=0;
-				for (size_t i=0;i<maingrid.dim2();++i) for (size_t j=0;j<maingrid.dim2();++j) draw_element(maingrid,i,j);
+				move(ymax-1,0);
+				clrtoeol();
+				if (savi==21) {
+					generator.cancel();
+					waiting=false;
+					maingrid=Grid(si);
+					solution=Grid();
+					show_game();
+				} else new_game(si,savi);
 				break;
 		}
 	}
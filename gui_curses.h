@@ -22,7 +22,13 @@
 #include <array>
 #include <tuple>
 #include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
 #include "objects.h"
+#include "bank.h"
+#include "background.h"
+#include "session.h"
 
 /**
  * \brief Class implementing the NCurses Gui
@@ -31,6 +37,14 @@
  */
 class CursesGui {
 	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The standard constructor initializes the interface. It does not touch the screen, which is only initialized by CursesGui::run.
+		 * \param pbank Bank of pregenerated puzzles used to start new games instantly, or null to always generate new grids
+		 */
+		CursesGui(PuzzleBank *pbank=0):bank(pbank),menu_mode(false),waiting(false) {}
+
 		/**
 		 * \brief Run the main game loop
 		 *
@@ -45,22 +59,86 @@ class CursesGui {
 			char hotkey;
 			char result;
 		};
-		const std::array<menu_item,4> menu={{
+		struct change {
+			size_t row;	//!< Row index of the cell
+			size_t column;	//!< Column index of the cell
+			elem_t value;	//!< Value of the cell before the move
+		};
+		const std::array<menu_item,5> menu={{
 			{"&New game","Generates a new grid",'N','n'},
 			{"&Clue","Displays a clue",'C','c'},
 			{"&Solve","Try to solve the grid",'S','s'},
+			{"&Undo","Undo the last move",'U','u'},
 			{"&Quit","Quit the game",'Q','q'}
 		}};	//!< Items of menu
 		size_t xmin;	//!< First column where the grid is displayed on screen
 		size_t xmax;	//!< Number of columns of the screen
 		size_t ymax;	//!< Number of lines of the screen
 		size_t xspace;	//!< Number of white spaces between the border of the cell and the element at its center
+		PuzzleBank *bank;	//!< Bank of pregenerated puzzles, null if there is none
 		Grid solution;	//!< Solution of the grid
 		Grid maingrid;	//!< Main grid displayed on screen
 		size_t menu_spacing;	//!< Number of spaces between too items in the menu
 		bool menu_mode;	//!< Tell if the user is in the menu
 		size_t si;	//!< Selected row
 		size_t sj;	//!< Selected column
+		std::vector<size_t> nconflicts;	//!< Number of peers holding the same value, for each cell of the main grid
+		std::deque<std::vector<change> > history;	//!< Cells changed by the last moves with their former values, the most recent move being at the back
+		static const size_t max_history=256;	//!< Maximal number of moves which can be undone
+		BackgroundGenerator generator;	//!< Generator of the new grids, running in a background thread
+		SolverSession session;	//!< Solving session following the moves on the main grid, so that solving again after a move is quick
+		bool waiting;	//!< Tell if the interface waits for a grid from the generator, an empty grid is displayed meanwhile
+		size_t wdimension;	//!< Dimension of the grid waited for
+		size_t wdifficulty;	//!< Level of difficulty of the grid waited for
+		std::chrono::steady_clock::time_point wstart;	//!< Time when the grid started to be waited for
+
+		/**
+		 * \brief Start a new game
+		 *
+		 * This function replaces the main grid by a new puzzle and stores its solution. The puzzle is drawn from the bank if one is available, or from the background generator if it has already generated it, which takes a constant time. Otherwise, an empty grid is displayed and the puzzle is requested to the generator. The function never waits for the generation, the puzzle is displayed later by CursesGui::poll_generator.
+		 * \param dimension Dimension of the new grid
+		 * \param difficulty Level of difficulty of the new grid, see Grid::generate
+		 */
+		void new_game(size_t dimension,size_t difficulty);
+
+		/**
+		 * \brief Display the main grid after it has been replaced
+		 *
+		 * This function clears the history and the selection, and draws the structure and all the elements of the main grid.
+		 */
+		void show_game();
+
+		/**
+		 * \brief Check if the grid waited for has been generated
+		 *
+		 * This function is called regularly by the main loop when the interface waits for a grid. It displays the grid if the generator has finished it, and updates the progress indicator otherwise.
+		 */
+		void poll_generator();
+
+		/**
+		 * \brief Change the value of a cell of the main grid
+		 *
+		 * This function sets or erases the value of a cell of the main grid, keeps the structures of the grid up to date through Grid::set_value and Grid::unset_value, and updates the conflicts of the cell and its peers. Only the cells whose display changes are drawn again, so the cost of the function only depends on the number of peers.
+		 * \param row Row index of the cell
+		 * \param column Column index of the cell
+		 * \param value New value of the cell, 0 to erase it
+		 */
+		void set_cell(size_t row,size_t column,elem_t value);
+
+		/**
+		 * \brief Save a move in the history
+		 *
+		 * This function must be called before each move, with the cells the move changes. It stores their current values, so that the move can be undone without copying the grid, and drops the oldest move if the history is full.
+		 * \param cells Cells changed by the move
+		 */
+		void remember(const std::vector<Grid::XYCoordinates> &cells);
+
+		/**
+		 * \brief Count the conflicts of all the cells of the main grid
+		 *
+		 * This function computes CursesGui::nconflicts from scratch. It must be called whenever the main grid is replaced.
+		 */
+		void reset_conflicts();
 
 		/**
 		 * \brief Draw the structure of the grid on screen
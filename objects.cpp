@@ -23,15 +23,44 @@
 #include <functional>
 #include <random>
 #include <list>
-#include "config.h"
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include "objects.h"
+#include "trace.h"
+#include "geometry.h"
 
 using namespace std;
 
-Grid Grid::_saved;
+const size_t Grid::placed;
 
-random_device rdevice;
-std::mt19937 rgenerator(rdevice());
+unsigned random_seed() {
+	static random_device rdevice;
+	static mutex rmutex;
+	lock_guard<mutex> lock(rmutex);
+	return rdevice();
+}
+
+thread_local std::mt19937 rgenerator(random_seed());
+
+size_t luby(size_t x) {
+	size_t size=1,seq=0;
+	while (size<x+1) {
+		++seq;
+		size=2*size+1;
+	}
+	while (size-1!=x) {
+		size=(size-1)>>1;
+		--seq;
+		x=x%size;
+	}
+	return (size_t)1<<seq;
+}
 
 /**************************************************************************/
 /*                           SudokuException                              */
@@ -50,39 +79,55 @@ const char* SudokuException::what() const throw() {
 Grid::SuCoordinates Grid::warp(size_t type,const Grid::XYCoordinates& coords) const {
 	if (type==0) return Grid::SuCoordinates(0,coords.row,coords.column);
 	if (type==1) return Grid::SuCoordinates(1,coords.column,coords.row);
-	return Grid::SuCoordinates(2,(coords.row/_dim)*_dim+(coords.column/_dim),(coords.row%_dim)*_dim+(coords.column%_dim));
+	size_t ind=coords.row*_dim2+coords.column;
+	const size_t *units=_geometry->units(ind);
+	size_t k=2;
+	while (k+1<_geometry->degree(ind) && units[k]/_dim2!=type) ++k;
+	return Grid::SuCoordinates(type,units[k]%_dim2,_geometry->positions(ind)[k]);
 }
 
 Grid::XYCoordinates Grid::warp(const Grid::SuCoordinates& coords) const {
 	if (coords.type==0) return Grid::XYCoordinates(coords.set,coords.index);
 	if (coords.type==1) return Grid::XYCoordinates(coords.index,coords.set);
-	return Grid::XYCoordinates((coords.set/_dim)*_dim+coords.index/_dim,(coords.set%_dim)*_dim+coords.index%_dim);
+	return unit_cell(coords.type*_dim2+coords.set,coords.index);
 }
 
-Grid::Grid(size_t pdim):_dim(pdim),_filled(0) {
-	if (pdim>0)	{
-		pdim*=pdim;
-		_dim2=pdim;
-		pdim*=pdim;
-		_cells=new Cell*[pdim];
-		for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(0,_dim2);
-		_alternatives=new size_t[pdim*3];
-		for (size_t i=0;i<pdim*3;++i) _alternatives[i]=_dim2;
+Grid::Grid(size_t pdim):Grid(pdim>0?Geometry::standard(pdim):shared_ptr<const Geometry>()) {
+}
+
+Grid::Grid(shared_ptr<const Geometry> pgeometry):_dim(0),_dim2(0),_cells(0),_filled(0),_broken(0),_alternatives(0),_geometry(pgeometry) {
+	if (_geometry) {
+		_dim=_geometry->dim();
+		_dim2=_geometry->dim2();
+		allocate();
 	}
 }
 
-Grid::Grid(std::istream &pin) {
+Grid::Grid(std::istream &pin,shared_ptr<const Geometry> pgeometry) {
 	_cells=0;
 	_alternatives=0;
-	read_from_stream(pin);
+	read_from_stream(pin,pgeometry);
+}
+
+Grid::Grid(size_t pdim,const unsigned char *packed,bool pfixed):Grid(pdim) {
+	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) if (packed[i*_dim2+j]!=0) set_value(i,j,packed[i*_dim2+j],pfixed);
 }
 
-Grid::Grid(const Grid &source):_dim(source._dim),_dim2(source._dim2),_filled(source._filled) {
+Grid::Grid(const Grid &source):_dim(source._dim),_dim2(source._dim2),_filled(source._filled),_broken(source._broken),_geometry(source._geometry) {
 	size_t pdim=_dim2*_dim2;
 	_cells=new Cell*[pdim];
 	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(*(source._cells[i*_dim2+j]));
-	_alternatives=new size_t[pdim*3];
-	for (size_t i=0;i<pdim*3;++i) _alternatives[i]=source._alternatives[i];
+	_alternatives=new size_t[nalternatives()];
+	for (size_t i=0;i<nalternatives();++i) _alternatives[i]=source._alternatives[i];
+}
+
+Grid::Grid(Grid &&source) noexcept:_dim(source._dim),_dim2(source._dim2),_cells(source._cells),_filled(source._filled),_broken(source._broken),_alternatives(source._alternatives),_geometry(std::move(source._geometry)) {
+	source._dim=0;
+	source._dim2=0;
+	source._cells=0;
+	source._filled=0;
+	source._broken=0;
+	source._alternatives=0;
 }
 
 Grid::~Grid() {
@@ -104,15 +149,20 @@ void Grid::free_all() {
 
 void Grid::clear() {
 	free_all();
+	allocate();
+}
+
+void Grid::allocate() {
 	_filled=0;
-	size_t pdim=_dim2*_dim2;
-	_cells=new Cell*[pdim];
+	_broken=0;
+	_cells=new Cell*[_dim2*_dim2];
 	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(0,_dim2);
-	_alternatives=new size_t[pdim*3];
-	for (size_t i=0;i<pdim*3;++i) _alternatives[i]=_dim2;
+	_alternatives=new size_t[nalternatives()];
+	for (size_t i=0;i<nalternatives();++i) _alternatives[i]=_dim2;
+	for (size_t k=0;k<_geometry->ncages();++k) restrict_cage(k);
 }
 
-void Grid::read_from_stream(istream &in) {
+void Grid::read_from_stream(istream &in,shared_ptr<const Geometry> pgeometry) {
 	free_all();
 	string line;
 	getline(in,line);
@@ -128,17 +178,15 @@ void Grid::read_from_stream(istream &in) {
 		_dim++;
 	}
 	_dim2=_dim;
-	_dim=(size_t)sqrt(_dim);
-	if (_dim*_dim!=_dim2) throw SudokuException(SudokuException::FORMAT_ERROR,"The dimension of the grid must be a square integer.");
+	if (pgeometry) {
+		if (pgeometry->dim2()!=_dim2) throw SudokuException(SudokuException::FORMAT_ERROR,"The dimension of the grid does not match its geometry.");
+		_geometry=pgeometry;
+	} else _geometry=default_geometry(_dim2);
+	_dim=_geometry->dim();
 	// Now that the dimension is known, construct the object
-	_filled=0;
-	_cells=new Cell*[_dim2*_dim2];
-	size_t i;
-	for (i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(0,_dim2);
-	_alternatives=new size_t[_dim2*_dim2*3];
-	for (i=0;i<_dim2*_dim2*3;++i) _alternatives[i]=_dim2;
+	allocate();
 	// Copy the first row back in the object
-	i=0;
+	size_t i=0;
 	for (list<elem_t>::iterator it=row.begin();it!=row.end();it++) {
 		if (*it!=0) set_value(0,i,*it);
 		++i;
@@ -164,146 +212,361 @@ void Grid::write_to_stream(ostream &out) const {
 	}
 }
 
+void Grid::read_line(const string &line,shared_ptr<const Geometry> pgeometry) {
+	size_t d2=(size_t)sqrt((double)line.size()+0.5);
+	if (d2*d2!=line.size() || d2==0) throw SudokuException(SudokuException::FORMAT_ERROR,"The length of the line is not a square integer.");
+	if (pgeometry && pgeometry->dim2()!=d2) throw SudokuException(SudokuException::FORMAT_ERROR,"The dimension of the grid does not match its geometry.");
+	*this=Grid(pgeometry?pgeometry:default_geometry(d2));
+	for (size_t i=0;i<line.size();++i) {
+		char c=line[i];
+		elem_t v;
+		if (c=='.' || c=='0') continue;
+		else if (c>='1' && c<='9') v=c-'0';
+		else if (c>='A' && c<='Z') v=c-'A'+10;
+		else throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid character in the line.");
+		if (v>d2) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid value in the line.");
+		set_value(i/d2,i%d2,v);
+	}
+}
+
+string Grid::write_line() const {
+	string line(_dim2*_dim2,'.');
+	for (size_t i=0;i<_dim2*_dim2;++i) {
+		elem_t v=_cells[i]->value;
+		if (v>=10) line[i]='A'+v-10;
+		else if (v>0) line[i]='0'+v;
+	}
+	return line;
+}
+
+shared_ptr<const Geometry> Grid::default_geometry(size_t dim2) {
+	// Choose the boxes with the most square shape, rows*columns=dim2 with rows<=columns
+	size_t rows=(size_t)sqrt((double)dim2+0.5);
+	while (rows>1 && dim2%rows!=0) --rows;
+	if (rows<=1) throw SudokuException(SudokuException::FORMAT_ERROR,"The dimension of the grid must be a product of two integers greater than 1.");
+	return Geometry::rectangular(rows,dim2/rows);
+}
+
+void Grid::write_packed(unsigned char *packed) const {
+	for (size_t i=0;i<_dim2*_dim2;++i) packed[i]=(unsigned char)_cells[i]->value;
+}
+
 Cell *Grid::operator()(size_t ptype,size_t pset,size_t pindex) const {
-	Grid::XYCoordinates xy=warp(Grid::SuCoordinates(ptype,pset,pindex));
-	return (*this)(xy.row,xy.column);
+	return _cells[_geometry->unit(ptype*_dim2+pset)[pindex]];
 }
 
-void Grid::operator=(const Grid &source) {
+Grid& Grid::operator=(const Grid &source) {
+	if (this==&source) return *this;
+	free_all();
 	_dim=source._dim;
 	_dim2=source._dim2;
 	_filled=source._filled;
+	_broken=source._broken;
+	_geometry=source._geometry;
 	size_t pdim=_dim2*_dim2;
 	if (source._cells!=0) {
 		_cells=new Cell*[pdim];
 		for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(*(source._cells[i*_dim2+j]));
-	} else _cells=0;
+	}
 	if (source._alternatives!=0) {
-		_alternatives=new size_t[pdim*3];
-		for (size_t i=0;i<pdim*3;++i) _alternatives[i]=source._alternatives[i];
-	} else _alternatives=0;
+		_alternatives=new size_t[nalternatives()];
+		for (size_t i=0;i<nalternatives();++i) _alternatives[i]=source._alternatives[i];
+	}
+	return *this;
 }
 
+Grid& Grid::operator=(Grid &&source) noexcept {
+	if (this==&source) return *this;
+	free_all();
+	_dim=source._dim;
+	_dim2=source._dim2;
+	_cells=source._cells;
+	_filled=source._filled;
+	_broken=source._broken;
+	_alternatives=source._alternatives;
+	_geometry=std::move(source._geometry);
+	source._dim=0;
+	source._dim2=0;
+	source._cells=0;
+	source._filled=0;
+	source._broken=0;
+	source._alternatives=0;
+	return *this;
+}
 
 void Grid::set_value(size_t prow,size_t pcolumn,elem_t pvalue,bool pfixed) {
-	Cell* cell=(*this)(prow,pcolumn);
+	size_t ind=prow*_dim2+pcolumn;
+	Cell* cell=_cells[ind];
 	cell->value=pvalue;
 	cell->fixed=pfixed;
 	_filled++;
+	const size_t *units=_geometry->units(ind);
+	size_t degree=_geometry->degree(ind);
 	if (cell->possible!=0) {
-		for (size_t t=0;t<3;++t) {
-			Grid::SuCoordinates coords=warp(t,Grid::XYCoordinates(prow,pcolumn));
-			for (size_t i=0;i<dim2();++i) if (i!=pvalue-1 && cell->possible[i]) {	// Update alternative levels for all other values for the sets containing this cell
-				size_t num=get_alternative(t,coords.set,i+1);
-				if (num!=0) {
-					set_alternative(t,coords.set,i+1,num-1); 
-#if (DEBUG_LEVEL>=3)
-					cerr << "\tUpdating alternative (" << t << "," << coords.set << "," << (i+1) << "," << num-1 << ")\n";
-#endif
-				}
+		for (size_t t=0;t<degree;++t) {
+			size_t *alt=_alternatives+units[t]*_dim2;
+			for (size_t i=0;i<_dim2;++i) if (i!=pvalue-1 && cell->possible[i] && alt[i]!=0 && alt[i]!=placed) {	// Update alternative levels for all other values for the sets containing this cell
+				alt[i]--;
 			}
 		}
 		delete[] cell->possible;
 		cell->possible=0;
 		cell->npossible=0;
 	}
-	// Update possible values of cells of the same row, column and inner square and alternatives levels
-	for (size_t t=0;t<3;++t) {
-		Grid::SuCoordinates coords=warp(t,Grid::XYCoordinates(prow,pcolumn));
-		for (size_t i=0;i<dim2();++i) {
-			Cell* c=(*this)(t,coords.set,i);
-			if (c->possible!=0 && c->possible[pvalue-1]) {	// Update possible values
-				c->npossible--;
-				c->possible[pvalue-1]=false;	
-				Grid::XYCoordinates xy=warp(Grid::SuCoordinates(t,coords.set,i));
-#if (DEBUG_LEVEL>=3)
-				cerr << "Updating cell (" << xy.row << "," << xy.column << ") because of new value " << pvalue << " in (" << prow << "," << pcolumn << ")\n";
-#endif
-				for (size_t s=0;s<3;++s) {	// Update alternatives levels for the value and the sets containing the cell which possible values have been updated
-					Grid::SuCoordinates coor=warp(s,xy);
-					size_t n=get_alternative(coor.type,coor.set,pvalue);
-					if (n!=0) {
-						set_alternative(coor.type,coor.set,pvalue,n-1);
-#if (DEBUG_LEVEL>=3)
-						cerr << "\tUpdating alternative (" << coor.type << "," << coor.set << "," << pvalue << "," << n-1 << ")\n";
-#endif
-					}
-				}
+	// Update possible values of the peers of the cell and alternatives levels, the cages of the cell and of the peers which lose a value must be restricted again
+	vector<size_t> cages;
+	if (_geometry->cage_of(ind)!=Geometry::nocage) cages.push_back(_geometry->cage_of(ind));
+	const size_t *peers=_geometry->peers(ind);
+	size_t npeers=_geometry->npeers(ind);
+	for (size_t k=0;k<npeers;++k) {
+		Cell* c=_cells[peers[k]];
+		if (c->possible!=0 && c->possible[pvalue-1]) {
+			eliminate(peers[k],pvalue);	// Update possible values and alternatives levels
+			size_t cage=_geometry->cage_of(peers[k]);
+			if (cage!=Geometry::nocage && find(cages.begin(),cages.end(),cage)==cages.end()) cages.push_back(cage);
+		}
+	}
+	// Delete alternative for the new value in all sets containing the cell
+	for (size_t t=0;t<degree;++t) {
+		_alternatives[units[t]*_dim2+pvalue-1]=placed;
+	}
+	for (size_t k:cages) if (!restrict_cage(k)) ++_broken;
+}
+
+bool Grid::restrict_cage(size_t pcage) {
+	const size_t *cells=_geometry->cage(pcage);
+	size_t size=_geometry->cage_size(pcage);
+	bool changed=true;
+	while (changed) {
+		changed=false;
+		// Empty cells of the cage, remaining sum and union of their possible values
+		size_t n=0,sum=_geometry->cage_sum(pcage);
+		unsigned candidates=0;
+		bool over=false;
+		for (size_t k=0;k<size;++k) {
+			Cell *c=_cells[cells[k]];
+			if (c->value!=0) {
+				if (c->value>sum) over=true;
+				else sum-=c->value;
+			} else {
+				++n;
+				if (c->possible!=0) for (size_t i=0;i<_dim2;++i) if (c->possible[i]) candidates|=1u<<i;
+			}
+		}
+		if (n==0) return !over && sum==0;
+		unsigned allowed=over?0:Geometry::cage_mask(n,sum,candidates);
+		if (allowed==candidates) return true;
+		for (size_t k=0;k<size;++k) {
+			Cell *c=_cells[cells[k]];
+			if (c->possible==0) continue;
+			for (size_t i=0;i<_dim2;++i) if (c->possible[i] && !(allowed & (1u<<i))) {
+				eliminate(cells[k],i+1);
+				changed=true;
+			}
+		}
+	}
+	return true;
+}
+
+void Grid::eliminate(size_t pcell,elem_t pvalue) {
+	Cell *c=_cells[pcell];
+	c->possible[pvalue-1]=false;
+	c->npossible--;
+	const size_t *punits=_geometry->units(pcell);
+	for (size_t s=0;s<_geometry->degree(pcell);++s) {
+		size_t &n=_alternatives[punits[s]*_dim2+pvalue-1];
+		if (n!=0 && n!=placed) n--;
+	}
+}
+
+void Grid::unset_value(size_t prow,size_t pcolumn) {
+	size_t ind=prow*_dim2+pcolumn;
+	Cell* cell=_cells[ind];
+	elem_t pvalue=cell->value;
+	if (pvalue==0) return;
+	if (_broken>0 && _geometry->cage_of(ind)!=Geometry::nocage && !restrict_cage(_geometry->cage_of(ind))) --_broken;	// The cage of the cell is not full any longer
+	cell->value=0;
+	cell->fixed=false;
+	_filled--;
+	const size_t *peers=_geometry->peers(ind);
+	size_t npeers=_geometry->npeers(ind);
+	// Restore the possible values of the cell
+	cell->possible=new bool[_dim2];
+	for (size_t i=0;i<_dim2;++i) cell->possible[i]=true;
+	cell->npossible=_dim2;
+	for (size_t k=0;k<npeers;++k) {
+		elem_t v=_cells[peers[k]]->value;
+		if (v!=0 && cell->possible[v-1]) {
+			cell->possible[v-1]=false;
+			cell->npossible--;
+		}
+	}
+	// Restore the erased value in the peers which do not see it any longer
+	vector<size_t> restored;
+	for (size_t k=0;k<npeers;++k) {
+		Cell *c=_cells[peers[k]];
+		if (c->possible!=0 && !c->possible[pvalue-1] && !is_seen(peers[k],pvalue)) {
+			c->possible[pvalue-1]=true;
+			c->npossible++;
+			restored.push_back(peers[k]);
+		}
+	}
+	// The cages of the cell and of the restored peers are restricted again from their values, their cells get all the values they do not see back first
+	vector<size_t> cages;
+	if (_geometry->cage_of(ind)!=Geometry::nocage) cages.push_back(_geometry->cage_of(ind));
+	for (auto p:restored) if (_geometry->cage_of(p)!=Geometry::nocage && find(cages.begin(),cages.end(),_geometry->cage_of(p))==cages.end()) cages.push_back(_geometry->cage_of(p));
+	vector<size_t> recounted;
+	for (size_t k:cages) {
+		for (size_t i=0;i<_geometry->cage_size(k);++i) {
+			size_t p=_geometry->cage(k)[i];
+			Cell *c=_cells[p];
+			if (c->possible==0) continue;
+			c->npossible=0;
+			for (elem_t v=1;v<=_dim2;++v) {
+				c->possible[v-1]=!is_seen(p,v);
+				if (c->possible[v-1]) c->npossible++;
+			}
+			recounted.push_back(p);
+		}
+	}
+	for (size_t k:cages) restrict_cage(k);
+	// Count again the alternatives of the sets which have changed
+	const size_t *units=_geometry->units(ind);
+	for (size_t t=0;t<_geometry->degree(ind);++t) for (elem_t v=1;v<=_dim2;++v) count_alternative(units[t],v);
+	for (auto p:restored) for (size_t t=0;t<_geometry->degree(p);++t) count_alternative(_geometry->units(p)[t],pvalue);
+	for (auto p:recounted) for (size_t t=0;t<_geometry->degree(p);++t) for (elem_t v=1;v<=_dim2;++v) count_alternative(_geometry->units(p)[t],v);
+}
+
+vector<Grid::XYCoordinates> Grid::peers(size_t prow,size_t pcolumn) const {
+	vector<XYCoordinates> p;
+	size_t ind=prow*_dim2+pcolumn;
+	const size_t *peers=_geometry->peers(ind);
+	p.reserve(_geometry->npeers(ind));
+	for (size_t k=0;k<_geometry->npeers(ind);++k) p.push_back(XYCoordinates(peers[k]/_dim2,peers[k]%_dim2));
+	return p;
+}
+
+size_t Grid::conflicts(size_t prow,size_t pcolumn) const {
+	size_t ind=prow*_dim2+pcolumn;
+	elem_t v=_cells[ind]->value;
+	if (v==0) return 0;
+	size_t n=0;
+	const size_t *peers=_geometry->peers(ind);
+	for (size_t k=0;k<_geometry->npeers(ind);++k) if (_cells[peers[k]]->value==v) ++n;
+	return n;
+}
+
+bool Grid::is_seen(size_t pcell,elem_t pvalue) const {
+	const size_t *peers=_geometry->peers(pcell);
+	for (size_t k=0;k<_geometry->npeers(pcell);++k) if (_cells[peers[k]]->value==pvalue) return true;
+	return false;
+}
+
+void Grid::count_alternative(size_t punit,elem_t pvalue) {
+	size_t n=0;
+	const size_t *cells=_geometry->unit(punit);
+	for (size_t i=0;i<_dim2;++i) {
+		Cell *c=_cells[cells[i]];
+		if (c->value==pvalue) {
+			n=placed;
+			break;
+		}
+		if (c->possible!=0 && c->possible[pvalue-1]) ++n;
+	}
+	_alternatives[punit*_dim2+pvalue-1]=n;
+}
+
+bool Grid::hint(size_t &prow,size_t &pcolumn,elem_t &pvalue,const Grid *psolution) const {
+	// Look for a value which differs from the solution, the deductions made from the current state would be wrong otherwise
+	if (psolution!=0) for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) {
+		elem_t v=(*this)(i,j)->value;
+		if (v!=0 && v!=(*psolution)(i,j)->value) {
+			prow=i;
+			pcolumn=j;
+			pvalue=(*psolution)(i,j)->value;
+			return true;
+		}
+	}
+	// Look for a cell with only one possible value left
+	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) {
+		Cell *c=(*this)(i,j);
+		if (c->value==0 && c->npossible==1) {
+			prow=i;
+			pcolumn=j;
+			pvalue=1;
+			while (!c->possible[pvalue-1]) ++pvalue;
+			return true;
+		}
+	}
+	// Look for a value with only one place left in a set
+	for (size_t ind=0;ind<nalternatives();++ind) if (_alternatives[ind]==1) {
+		Alternative alt=ind_alternative(ind);
+		for (size_t i=0;i<_dim2;++i) {
+			Cell *c=(*this)(alt.type,alt.set,i);
+			if (c->possible!=0 && c->possible[alt.value-1]) {
+				XYCoordinates xy=unit_cell(alt.type*_dim2+alt.set,i);
+				prow=xy.row;
+				pcolumn=xy.column;
+				pvalue=alt.value;
+				return true;
 			}
 		}
-		// Delete alternative for the new value in all sets containing the cell
-		set_alternative(t,coords.set,pvalue,0); 
-#if (DEBUG_LEVEL>=3)
-		cerr << "\tUpdating alternative (" << t << "," << coords.set << "," << pvalue << "," << 0 << ")\n";
-#endif
 	}
+	return false;
 }
 
 size_t Grid::solve(SolveType type,std::function<void(const Grid&)> callback) const {
+	SearchContext context(rgenerator);
+	return solve(type,callback,context);
+}
+
+size_t Grid::solve(SolveType type,const std::function<void(const Grid&)> &callback,SearchContext &context) const {
 	size_t i,j;
 	Grid source=*this;
-#if (DEBUG_LEVEL>=1)
-	cerr << "\nSolve\n" << source << "\n";
-#endif
 	size_t min=0;
 	size_t min2=0;
 	size_t ind,indi,indj;
 	while ((min<=1 || min2<=1) && source._filled!=source._dim2*source._dim2) {	// Fill as much as possible by deduction
-#if (DEBUG_LEVEL>=3)
-		cerr << "New iteration (" << source._filled << ")\n";
-#endif
-		// Debug output
-#if (DEBUG_LEVEL>=2)
-		cerr << "Alternatives\n";
-		for (i=0;i<source._dim2;++i) {
-			for (size_t t=0;t<3;++t) {
-				for (j=0;j<source._dim2;++j) {
-					cerr << source._alternatives[t*source._dim2*source._dim2+i*source._dim2+j] << " ";
-				}
-				cerr << "\t";
-			}
-			cerr << endl;
-		}
-		cerr << "\nPossibles\n";
-		for (i=0;i<source._dim2;++i) {
-			for (j=0;j<source._dim2;++j) {
-				Cell *c=source(i,j);
-				if (c->possible==0) cerr << "         ";
-				else for (size_t t=0;t<source._dim2;++t) {
-					if (c->possible[t]) cerr << (t+1); else cerr << " ";
-				}
-				cerr << " | ";
-			}
-			cerr << endl;
+		if (source._broken>0) {	// Dead end, a full cage has a wrong sum
+			Trace::record(Trace::DEADEND,context.depth);
+			return 0;
 		}
-#endif
 		// Look for the alternative with the smallest number of possibilities
 		min=source._dim2+1;
 		ind=0;
-		for (i=0;i<source._dim2*source._dim2*3;++i) if (source._alternatives[i]>0 && source._alternatives[i]<min) {
+		for (i=0;i<source.nalternatives();++i) if (source._alternatives[i]<min) {
+			if (source._alternatives[i]==0) {	// Dead end, a value has no place left in a set
+				Trace::record(Trace::DEADEND,context.depth);
+				return 0;
+			}
+			if (source._alternatives[i]>1 && context.interchangeable!=0 && (*context.interchangeable)[i%source._dim2] && !source.is_placed(i%source._dim2+1)) continue;	// The places of an unused interchangeable value are symmetric copies of the places of the others
 			min=source._alternatives[i];
 			ind=i;
 		}
 		// Look for the cell with the smallest number of possibilities
 		min2=source._dim2+1;
 		indi=0;indj=0;
-		for (i=0;i<source._dim2;++i) for (j=0;j<source._dim2;++j) if (source(i,j)->npossible>0 && source(i,j)->npossible<min2) {
-			min2=source(i,j)->npossible;
-			indi=i;
-			indj=j;
+		for (i=0;i<source._dim2;++i) for (j=0;j<source._dim2;++j) {
+			if (source(i,j)->value==0 && source(i,j)->npossible==0) {	// Dead end, an empty cell has no possible value left
+				Trace::record(Trace::DEADEND,context.depth,i,j);
+				return 0;
+			}
+			if (source(i,j)->npossible>0 && source(i,j)->npossible<min2) {
+				min2=source(i,j)->npossible;
+				indi=i;
+				indj=j;
+			}
 		}
 		// Now choose the better option. If there is only one possibility, put the number.
 		if (min==1) {	// Case when a new element can be found by deduction ("There must be a 4 in this row, and it can be neither here, nor here, nor here...")
 			Alternative alt=source.ind_alternative(ind);
-#if (DEBUG_LEVEL>=2)
-			cerr << "Alternative(" << alt.type << "," << alt.set << "," << alt.value << ")" << endl;
-#endif
 			i=0;
 			while (i<source._dim2) {
-				Grid::XYCoordinates coords=source.warp(Grid::SuCoordinates(alt.type,alt.set,i));
+				Grid::XYCoordinates coords=source.unit_cell(alt.type*source._dim2+alt.set,i);
 				Cell *cell=source(coords.row,coords.column);
 				if (cell->possible!=0 && cell->possible[alt.value-1]) {
 					source.set_value(coords.row,coords.column,alt.value);
+					Trace::record(Trace::DEDUCE,context.depth,coords.row,coords.column,alt.value);
 					i=source._dim2;
 				}
 				++i;
@@ -312,14 +575,20 @@ size_t Grid::solve(SolveType type,std::function<void(const Grid&)> callback) con
 			i=0;
 			Cell *cell=source(indi,indj);
 			while (i<source._dim2 && (cell->possible==0 || !cell->possible[i])) ++i;
-#if (DEBUG_LEVEL>=2)
-			cerr << "Possible(" << indi << "," << indj << "," << i << ")" << endl;
-#endif
-			if (i<source._dim2) source.set_value(indi,indj,i+1);
+			if (i<source._dim2) {
+				source.set_value(indi,indj,i+1);
+				Trace::record(Trace::DEDUCE,context.depth,indi,indj,i+1);
+			}
 		}
 	}
 	// If the grid is filled, return
+	if (source._broken>0) {
+		Trace::record(Trace::DEADEND,context.depth);
+		return 0;
+	}
 	if (source._filled==source._dim2*source._dim2) {
+		Trace::record(Trace::SOLUTION,context.depth);
+		if (context.probe) context.solutions=context.weight;
 		if (callback!=0) callback(source);
 		return 1;
 	}
@@ -344,119 +613,498 @@ size_t Grid::solve(SolveType type,std::function<void(const Grid&)> callback) con
 	}
 	if (min<min2) {
 		Alternative alt=source.ind_alternative(ind);
-		std::uniform_int_distribution<> dis(0,source._alternatives[ind]-1);
-		j=0;
+		// With FIND_ANY, the possibilities are tried in a circular order from a random one, so that the search stays complete
+		size_t start=(type==FIND_ANY)?std::uniform_int_distribution<size_t>(0,source._alternatives[ind]-1)(context.generator):0;
+		size_t nbranches=source._alternatives[ind];
+		if (context.probe) probe_branches(context,nbranches);
+		j=first_branch(context);
 		Grid::XYCoordinates coords;
 		while (j<source._alternatives[ind] && nfound<maxfound) {
-			if (type==FIND_ANY) {
-				i=0;num=dis(rgenerator);
-			} else num=0;
+			if (context.stop!=0 && context.stop->load(memory_order_relaxed)) context.aborted=true;
+			if (context.maxnodes!=0 && context.nodes>=context.maxnodes) context.aborted=true;
+			if (context.aborted) break;
+			++context.nodes;
+			if (context.checkpoint!=0) start_branch(context,j);
+			i=0;
+			num=(start+j)%source._alternatives[ind];
 			k=0;
 			while (i<source._dim2 && k<=num) {
-				coords=source.warp(Grid::SuCoordinates(alt.type,alt.set,i));
+				coords=source.unit_cell(alt.type*source._dim2+alt.set,i);
 				Cell *cell=source(coords.row,coords.column);
 				if (cell->possible!=0 && cell->possible[alt.value-1]) ++k;
 				++i;
 			}
 			--i;
 			Grid *hypothesis=new Grid(source);
-#if (DEBUG_LEVEL>=2)
-			cerr << "Trying " << alt.value << " on cell (" << coords.row << "," << coords.column << ") based on Alternative(" << alt.type << "," << alt.set << "," << alt.value << ")\n";
-#endif
 			hypothesis->set_value(coords.row,coords.column,alt.value);
-			size_t res=hypothesis->solve(type,callback);
+			Trace::record(Trace::BRANCH,context.depth,coords.row,coords.column,alt.value);
+			if (++context.depth>context.maxdepth) context.maxdepth=context.depth;
+			size_t res;
+			if (context.unit!=0 && context.depth==context.splitdepth) {	// The branch is handed as a unit instead of being explored
+				(*context.unit)(*hypothesis);
+				res=1;
+			} else res=hypothesis->solve(type,callback,context);
+			--context.depth;
+			context.resume=0;
+			if (context.checkpoint!=0) context.path.pop_back();
+			Trace::record(Trace::BACKTRACK,context.depth,coords.row,coords.column,alt.value);
 			delete hypothesis;
 			nfound+=res;
-			++i;
 			++j;
+			if (context.probe) break;	// A probe follows a single branch
 		}
+		if (context.probe) context.weight/=nbranches;
 	} else {
 		Cell *cell=source(indi,indj);
-		std::uniform_int_distribution<> dis(0,cell->npossible-1);
-		j=0;
+		size_t start=(type==FIND_ANY)?std::uniform_int_distribution<size_t>(0,cell->npossible-1)(context.generator):0;
+		size_t nbranches=cell->npossible;
+		if (context.probe) probe_branches(context,nbranches);
+		// Only the smallest of the unused interchangeable values is tried, the others would give symmetric copies of its solutions
+		elem_t first=0;
+		if (context.interchangeable!=0) for (elem_t v=1;v<=source._dim2 && first==0;++v) if ((*context.interchangeable)[v-1] && !source.is_placed(v)) first=v;
+		j=first_branch(context);
 		while (j<cell->npossible && nfound<maxfound) {
-			if (type==FIND_ANY) {
-				i=0;num=dis(rgenerator);
-			} else num=0;
+			i=0;
+			num=(start+j)%cell->npossible;
 			k=0;
 			while (i<source._dim2 && k<=num) {
 				if (cell->possible[i]) ++k;
 				++i;
 			}
 			--i;
+			if (first!=0 && i+1!=first && (*context.interchangeable)[i] && !source.is_placed(i+1)) {
+				++j;
+				continue;
+			}
+			if (context.stop!=0 && context.stop->load(memory_order_relaxed)) context.aborted=true;
+			if (context.maxnodes!=0 && context.nodes>=context.maxnodes) context.aborted=true;
+			if (context.aborted) break;
+			++context.nodes;
+			if (context.checkpoint!=0) start_branch(context,j);
 			Grid *hypothesis=new Grid(source);
-#if (DEBUG_LEVEL>=2)
-			cerr << "Trying " << (i+1) << " on cell (" << indi << "," << indj << ") based on Possible(" << indi << "," << indj << ")\n";
-#endif
 			hypothesis->set_value(indi,indj,i+1);
-			size_t res=hypothesis->solve(type,callback);
+			Trace::record(Trace::BRANCH,context.depth,indi,indj,i+1);
+			if (++context.depth>context.maxdepth) context.maxdepth=context.depth;
+			size_t res;
+			if (context.unit!=0 && context.depth==context.splitdepth) {	// The branch is handed as a unit instead of being explored
+				(*context.unit)(*hypothesis);
+				res=1;
+			} else res=hypothesis->solve(type,callback,context);
+			--context.depth;
+			context.resume=0;
+			if (context.checkpoint!=0) context.path.pop_back();
+			Trace::record(Trace::BACKTRACK,context.depth,indi,indj,i+1);
 			delete hypothesis;
 			nfound+=res;
-			++i;
 			++j;
+			if (context.probe) break;	// A probe follows a single branch
 		}
+		if (context.probe) context.weight/=nbranches;
 	}
 	// Execute the callback function on the final grid and return
-#if (DEBUG_LEVEL>=1)
-	cerr << "Return from solve with nfound=" << nfound << " and grid :\n" << source << "\n";
-#endif
 	return nfound;
 }
 
-bool Grid::fill() {
-	size_t res=solve(FIND_ANY,&Grid::save);
+void Grid::probe_branches(SearchContext &context,size_t nbranches) {
+	if (context.profile.size()<=context.depth) context.profile.resize(context.depth+1,0);
+	context.weight*=nbranches;
+	context.profile[context.depth]+=context.weight;
+}
+
+Grid::Estimate Grid::estimate(double seconds,size_t maxprobes) const {
+	Estimate result;
+	result.probes=0;
+	double sumnodes=0,sumnodes2=0,sumsolutions=0,sumsolutions2=0;
+	size_t ncalls=0;
+	auto start=chrono::steady_clock::now();
+	double elapsed=0;
+	do {
+		SearchContext context(rgenerator);
+		context.probe=true;
+		solve(FIND_ANY,0,context);
+		ncalls+=context.nodes+1;
+		double nodes=0;
+		for (size_t d=0;d<context.profile.size();++d) {
+			nodes+=context.profile[d];
+			if (result.profile.size()<=d) result.profile.resize(d+1,0);
+			result.profile[d]+=context.profile[d];
+		}
+		sumnodes+=nodes;
+		sumnodes2+=nodes*nodes;
+		sumsolutions+=context.solutions;
+		sumsolutions2+=context.solutions*context.solutions;
+		++result.probes;
+		elapsed=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	} while (elapsed<seconds && (maxprobes==0 || result.probes<maxprobes));
+	double n=result.probes;
+	result.nodes=sumnodes/n;
+	result.solutions=sumsolutions/n;
+	for (size_t d=0;d<result.profile.size();++d) result.profile[d]/=n;
+	// Half-widths of the normal confidence intervals, with the unbiased variance of the probes
+	double z=1.96;
+	result.nodes_error=(n>1)?z*sqrt(max(sumnodes2-n*result.nodes*result.nodes,0.0)/(n-1)/n):numeric_limits<double>::infinity();
+	result.solutions_error=(n>1)?z*sqrt(max(sumsolutions2-n*result.solutions*result.solutions,0.0)/(n-1)/n):numeric_limits<double>::infinity();
+	result.seconds=(result.nodes+1)*elapsed/ncalls;
+	return result;
+}
+
+size_t Grid::first_branch(SearchContext &context) {
+	if (context.resume==0 || context.depth>=context.resume->size()) return 0;
+	size_t branch=(*context.resume)[context.depth];
+	if (context.depth+1==context.resume->size()) context.resume=0;	// The branch has not been started yet, it is explored from its beginning
+	return branch;
+}
+
+void Grid::start_branch(SearchContext &context,size_t branch) {
+	context.path.push_back(branch);
+	if ((context.nodes & 0xff)!=0) return;
+	auto now=chrono::steady_clock::now();
+	if (chrono::duration<double>(now-context.last).count()<context.period) return;
+	(*context.checkpoint)(context.path,context.nodes);
+	context.last=now;
+}
+
+size_t Grid::enumerate(std::function<void(const Grid&)> callback,std::function<void(const vector<size_t>&,size_t)> checkpoint,double period,const vector<size_t> &resume) const {
+	SearchContext context(rgenerator);
+	if (!resume.empty()) context.resume=&resume;
+	if (checkpoint) context.checkpoint=&checkpoint;
+	context.period=period;
+	context.last=chrono::steady_clock::now();
+	return solve(FIND_ALL,callback,context);
+}
+
+bool Grid::enumerate(std::function<void(const Grid&)> callback,size_t maxnodes,size_t &nsolutions) const {
+	SearchContext context(rgenerator);
+	context.maxnodes=maxnodes;
+	nsolutions=solve(FIND_ALL,callback,context);
+	return !context.aborted;
+}
+
+size_t Grid::enumerate(std::function<void(const Grid&)> callback,const vector<bool> &interchangeable) const {
+	SearchContext context(rgenerator);
+	if (find(interchangeable.begin(),interchangeable.end(),true)!=interchangeable.end()) context.interchangeable=&interchangeable;
+	return solve(FIND_ALL,callback,context);
+}
+
+bool Grid::is_placed(elem_t pvalue) const {
+	for (size_t u=0;u<_dim2;++u) if (_alternatives[u*_dim2+pvalue-1]==placed) return true;
+	return false;
+}
+
+size_t Grid::split(size_t depth,std::function<void(const Grid&)> unit) const {
+	if (depth==0) {
+		unit(*this);
+		return 1;
+	}
+	SearchContext context(rgenerator);
+	context.unit=&unit;
+	context.splitdepth=depth;
+	return solve(FIND_ALL,unit,context);
+}
+
+static const size_t portfolio_dim2=9;	//!< Largest number of values of the grids which are always solved by a single search, without starting threads
+
+size_t Grid::solve_portfolio(std::function<void(const Grid&)> callback,size_t nthreads,const atomic<bool> *stop) const {
+	if (nthreads==0) {
+		// The calling thread tries a single search first, without limit on small grids and with a short budget on the others, so that the threads are only started for the hard grids
+		mt19937 generator(random_seed());
+		SearchContext context(generator);
+		context.maxnodes=(_dim2<=portfolio_dim2)?0:2*_dim2*_dim2;
+		context.stop=stop;
+		Grid found;
+		size_t n=solve(FIND_ANY,[&found](const Grid &g) {found=g;},context);
+		if (n>0 || !context.aborted) {
+			if (n>0 && callback!=0) callback(found);
+			return n;
+		}
+		if (stop!=0 && stop->load()) return 0;
+		nthreads=max(thread::hardware_concurrency(),1u);
+	}
+	atomic<bool> done(false);
+	mutex m;
+	condition_variable cv;
+	Grid winner;
+	size_t result=0;
+	auto run=[&](size_t k) {
+		mt19937 generator(random_seed());
+		size_t unit=((k%2==0)?2:8)*_dim2*_dim2;	// Half of the searches restart more often than the other half
+		Grid found;
+		std::function<void(const Grid&)> keep=[&found](const Grid &g) {found=g;};
+		for (size_t r=0;!done.load();++r) {
+			SearchContext context(generator);
+			context.maxnodes=luby(r)*unit;
+			context.stop=&done;
+			size_t n=solve(FIND_ANY,keep,context);
+			if (n>0 || !context.aborted) {	// Either a solution has been found, or the search was complete and there is no solution
+				lock_guard<mutex> lock(m);
+				if (!done.load()) {
+					result=n;
+					if (n>0) winner=std::move(found);
+					done=true;
+				}
+				cv.notify_all();
+				return;
+			}
+		}
+	};
+	vector<thread> threads;
+	for (size_t k=0;k<nthreads;++k) threads.push_back(thread(run,k));
+	{
+		unique_lock<mutex> lock(m);
+		while (!done.load()) {
+			if (stop!=0 && stop->load()) done=true;
+			else cv.wait_for(lock,chrono::milliseconds(10));
+		}
+	}
+	for (auto &t:threads) t.join();
+	if (result>0 && callback!=0) callback(winner);
+	return result;
+}
+
+bool Grid::fill(const atomic<bool> *stop) {
+	Grid found;
+	size_t res=solve_portfolio([&found](const Grid &g) {found=g;},0,stop);
 	if (res==0) return false;
-	free_all();
-	_cells=new Cell*[_dim2*_dim2];
-	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _cells[i*_dim2+j]=new Cell(*(_saved._cells[i*_dim2+j]));
+	*this=std::move(found);
 	return true;
 }
 
-void Grid::save() const {
-	_saved.free_all();
-	_saved._dim=_dim;
-	_saved._dim2=_dim2;
-	_saved._alternatives=0;
-	size_t pdim=_dim2*_dim2;
-	_saved._cells=new Cell*[pdim];
-	for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) _saved._cells[i*_dim2+j]=new Cell(*(_cells[i*_dim2+j]));
+/**
+ * \brief Exchange values between two parallel lines of a full grid
+ *
+ * The two lines must cross the same boxes. The values found in a column (or a row) of the first line and in the same column of the second line are exchanged along a cycle: the value taken by the first line is the one it loses in another column, so that the lines still hold all the values. The columns and the boxes keep the same values, so the grid stays valid.
+ * \param values Values of the full grid, row by row
+ * \param d2 Number of rows of the grid
+ * \param first Index of the first line
+ * \param second Index of the second line
+ * \param columns Tell if the lines are columns instead of rows
+ * \param start Position on the lines where the cycle starts
+ */
+static void exchange_cycle(vector<elem_t> &values,size_t d2,size_t first,size_t second,bool columns,size_t start) {
+	auto index=[d2,columns](size_t line,size_t k) {return columns?k*d2+line:line*d2+k;};
+	vector<size_t> position(d2+1);
+	for (size_t k=0;k<d2;++k) position[values[index(first,k)]]=k;
+	size_t k=start;
+	do {
+		size_t next=position[values[index(second,k)]];
+		swap(values[index(first,k)],values[index(second,k)]);
+		k=next;
+	} while (k!=start);
+}
+
+/**
+ * \brief Draw a random permutation of the lines of a grid with rectangular boxes
+ *
+ * \param d2 Number of lines
+ * \param size Number of lines of a group (band or stack)
+ * \return Permutation which shuffles the groups, then the lines inside each group
+ */
+static vector<size_t> permute_lines(size_t d2,size_t size) {
+	vector<size_t> groups(d2/size);
+	for (size_t g=0;g<groups.size();++g) groups[g]=g;
+	shuffle(groups.begin(),groups.end(),rgenerator);
+	vector<size_t> permutation(d2);
+	for (size_t g=0;g<groups.size();++g) {
+		for (size_t k=0;k<size;++k) permutation[g*size+k]=groups[g]*size+k;
+		shuffle(permutation.begin()+g*size,permutation.begin()+(g+1)*size,rgenerator);
+	}
+	return permutation;
+}
+
+static mutex seedmutex;	//!< Mutex protecting the pools of seed solutions
+static map<pair<size_t,size_t>,vector<vector<elem_t> > > seeds;	//!< Pools of seed solutions of the grids with rectangular boxes, by size of the boxes
+static const size_t seedpool=8;	//!< Maximal number of seed solutions kept for each geometry
+
+Grid Grid::synthesize(shared_ptr<const Geometry> pgeometry,const atomic<bool> *stop) {
+	size_t r=pgeometry->box_rows(),c=pgeometry->box_columns();
+	if (r==0 || pgeometry->diagonals() || pgeometry->ncages()>0) {
+		Grid source(pgeometry);
+		if (!source.fill(stop)) return Grid();
+		return source;
+	}
+	size_t d2=pgeometry->dim2();
+	// Take a seed, the first one is the pattern grid whose row i is shifted by c*(i%r)+i/r
+	vector<elem_t> values;
+	size_t slot;
+	{
+		lock_guard<mutex> lock(seedmutex);
+		vector<vector<elem_t> > &pool=seeds[make_pair(r,c)];
+		if (pool.empty()) {
+			pool.push_back(vector<elem_t>(d2*d2));
+			for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) pool[0][i*d2+j]=(c*(i%r)+i/r+j)%d2+1;
+		}
+		slot=uniform_int_distribution<size_t>(0,pool.size()-1)(rgenerator);
+		values=pool[slot];
+	}
+	// Renew the seed by exchanges of values between the lines of a band or of a stack
+	uniform_int_distribution<size_t> position(0,d2-1);
+	for (size_t n=0;n<d2;++n) {
+		bool columns=(rgenerator()%2==0);
+		size_t size=columns?c:r;
+		if (size<2) {
+			columns=!columns;
+			size=columns?c:r;
+			if (size<2) break;
+		}
+		size_t group=position(rgenerator)/size*size;
+		size_t first=uniform_int_distribution<size_t>(0,size-1)(rgenerator);
+		size_t second=uniform_int_distribution<size_t>(0,size-2)(rgenerator);
+		if (second>=first) ++second;
+		exchange_cycle(values,d2,group+first,group+second,columns,position(rgenerator));
+	}
+	{
+		lock_guard<mutex> lock(seedmutex);
+		vector<vector<elem_t> > &pool=seeds[make_pair(r,c)];
+		if (pool.size()<seedpool) pool.push_back(values);
+		else pool[slot]=values;
+	}
+	// Apply the transformations of the grid
+	vector<elem_t> labels(d2);
+	for (size_t v=0;v<d2;++v) labels[v]=v+1;
+	shuffle(labels.begin(),labels.end(),rgenerator);
+	vector<size_t> rows=permute_lines(d2,r),cols=permute_lines(d2,c);
+	bool transpose=(r==c && rgenerator()%2==0);
+	Grid grid(pgeometry);
+	for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) {
+		elem_t v=labels[values[rows[i]*d2+cols[j]]-1];
+		if (transpose) grid.set_value(j,i,v);
+		else grid.set_value(i,j,v);
+	}
+	return grid;
+}
+
+Grid Grid::generate(size_t dimension,size_t difficulty,Grid *solution,bool symmetric) {
+	return generate(Geometry::standard(dimension),difficulty,solution,symmetric);
 }
 
-Grid Grid::generate(size_t dimension,size_t difficulty,Grid *solution) {
+Grid Grid::generate(shared_ptr<const Geometry> pgeometry,size_t difficulty,Grid *solution,bool symmetric,const atomic<bool> *stop) {
 	// Generate a full valid grid
-	Grid source(dimension);
-	source.fill();
-	if (solution!=0) *solution=source;
-	std::uniform_int_distribution<> dis(0,source._dim2-1);
-	// Create a grid by copying some elements from the source grid
-	Grid generated(dimension);	
-	size_t i=0;
-	while (i<source._dim2*source._dim+difficulty) {
-		size_t j=dis(rgenerator);
-		size_t k=dis(rgenerator);
-		if (generated(j,k)->value==0) {
-			generated.set_value(j,k,source(j,k)->value,true);
-			++i;
+	Grid source=synthesize(pgeometry,stop);
+	if (source._dim2==0) return Grid();
+	// Remove elements as long as the solution is unique
+	Grid generated=dig(source,source._dim2*source._dim+difficulty,symmetric,stop);
+	if (generated._dim2==0) return generated;
+	if (solution!=0) *solution=std::move(source);
+	return generated;
+}
+
+Grid Grid::dig(const Grid &solution,size_t minclues,bool symmetric,const atomic<bool> *stop) {
+	return dig(solution,minclues,symmetric,stop,std::function<int(const Grid&)>());
+}
+
+Grid Grid::dig(const Grid &solution,size_t minclues,bool symmetric,const atomic<bool> *stop,const std::function<int(const Grid&)> &judge) {
+	size_t d2=solution._dim2;
+	Grid puzzle(solution._geometry);
+	for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) puzzle.set_value(i,j,solution(i,j)->value,true);
+	size_t nclues=d2*d2;
+	vector<size_t> order(d2*d2);
+	for (size_t i=0;i<order.size();++i) order[i]=i;
+	shuffle(order.begin(),order.end(),rgenerator);
+	vector<XYCoordinates> removed;
+	SearchContext context(rgenerator);
+	context.stop=stop;
+	for (size_t ind:order) {
+		if (nclues<=minclues) break;
+		removed.clear();
+		removed.push_back(XYCoordinates(ind/d2,ind%d2));
+		if (symmetric && ind!=d2*d2-1-ind) removed.push_back(XYCoordinates(d2-1-ind/d2,d2-1-ind%d2));
+		if (puzzle(removed[0].row,removed[0].column)->value==0 || nclues<minclues+removed.size()) continue;
+		for (auto xy:removed) puzzle.unset_value(xy.row,xy.column);
+		// The grid is still unique if no solution has another value in one of the removed cells
+		bool unique=true;
+		for (size_t k=0;k<removed.size() && unique;++k) {
+			Cell *cell=puzzle(removed[k].row,removed[k].column);
+			for (elem_t v=1;v<=d2 && unique;++v) if (v!=solution(removed[k].row,removed[k].column)->value && cell->possible[v-1]) {
+				Grid test(puzzle);
+				test.set_value(removed[k].row,removed[k].column,v);
+				if (test.solve(FIND_ONE,0,context)>0) unique=false;
+				if (context.aborted) return Grid();
+			}
 		}
+		int verdict=0;
+		if (unique && judge) verdict=judge(puzzle);
+		if (unique && verdict>=0) nclues-=removed.size();
+		else for (auto xy:removed) puzzle.set_value(xy.row,xy.column,solution(xy.row,xy.column)->value,true);
+		if (verdict>0) break;
 	}
-	// Add elements until solution is unique
-	bool found=false;
-	while (!found) {
-		// Test new grid if the solution is unique
-		Grid test(generated);
-		bool done=false;
-		if (test.solve(Grid::FIND_UNIQUE,0)) found=true;
-		else while (!done) { // Otherwise, add one element randomly and prepare next loop
-			size_t j=dis(rgenerator);
-			size_t k=dis(rgenerator);
-			if (generated(j,k)->value==0) {
-				generated.set_value(j,k,source(j,k)->value,true);
-				done=true;
+	return puzzle;
+}
+
+bool Grid::deduce(bool hidden) {
+	bool found=true;
+	while (found && _filled<_dim2*_dim2) {
+		found=false;
+		for (size_t i=0;i<_dim2;++i) for (size_t j=0;j<_dim2;++j) {
+			Cell *c=(*this)(i,j);
+			if (c->value==0 && c->npossible==1) {
+				elem_t v=1;
+				while (!c->possible[v-1]) ++v;
+				set_value(i,j,v);
+				found=true;
+			}
+		}
+		if (found || !hidden) continue;
+		for (size_t ind=0;ind<nalternatives() && !found;++ind) if (_alternatives[ind]==1) {
+			Alternative alt=ind_alternative(ind);
+			for (size_t i=0;i<_dim2;++i) {
+				XYCoordinates xy=unit_cell(alt.type*_dim2+alt.set,i);
+				Cell *c=(*this)(xy.row,xy.column);
+				if (c->possible!=0 && c->possible[alt.value-1]) {
+					set_value(xy.row,xy.column,alt.value);
+					found=true;
+					break;
+				}
 			}
 		}
 	}
-	// Return
-	return generated;
+	return _filled==_dim2*_dim2 && _broken==0;
+}
+
+bool Grid::rate(Rating &rating,size_t maxscore,const atomic<bool> *stop) const {
+	rating.level=Rating::NAKED_SINGLES;
+	rating.nodes=0;
+	rating.depth=0;
+	Grid source(*this);
+	if (source.deduce(false)) return true;
+	rating.level=Rating::HIDDEN_SINGLES;
+	if (rating.score()>maxscore) return false;
+	if (source.deduce(true)) return true;
+	rating.level=Rating::SEARCH;
+	if (rating.score()>maxscore) return false;
+	// The score is larger than the number of hypotheses, so the search can be aborted at the limit
+	SearchContext context(rgenerator);
+	context.stop=stop;
+	context.maxnodes=maxscore-rating.score()+1;
+	source.solve(FIND_UNIQUE,0,context);
+	rating.nodes=context.nodes;
+	rating.depth=context.maxdepth;
+	return !context.aborted && rating.score()<=maxscore;
+}
+
+Grid Grid::generate_rated(shared_ptr<const Geometry> pgeometry,size_t minscore,size_t maxscore,Rating *rating,Grid *solution,bool symmetric,const atomic<bool> *stop,size_t *ncandidates) {
+	Rating current,accepted;
+	bool inband=false;
+	std::function<int(const Grid&)> judge=[&](const Grid &puzzle) {
+		if (!puzzle.rate(current,maxscore,stop)) return -1;
+		if (current.score()<minscore) return inband?-1:0;
+		inband=true;
+		accepted=current;
+		return 0;
+	};
+	if (ncandidates!=0) *ncandidates=0;
+	while (true) {
+		if (stop!=0 && stop->load()) return Grid();
+		Grid source=synthesize(pgeometry,stop);
+		if (source._dim2==0) return Grid();
+		if (ncandidates!=0) ++*ncandidates;
+		inband=false;
+		Grid generated=dig(source,0,symmetric,stop,judge);
+		if (generated._dim2==0) return generated;
+		if (!inband) continue;
+		if (rating!=0) *rating=accepted;
+		if (solution!=0) *solution=std::move(source);
+		return generated;
+	}
 }
 
 istream& operator>>(istream &in,Grid *grid) {
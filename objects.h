@@ -22,6 +22,13 @@
 #include <iostream>
 #include <string>
 #include <functional>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <limits>
+#include "geometry.h"
 
 typedef size_t elem_t;	//!< Basic type of elements of the grid
 
@@ -38,7 +45,8 @@ class SudokuException:public std::exception {
 		 * The set gathers all error codes that the exception may hold.
 		 */
 		enum Code {
-			FORMAT_ERROR	//!< Invalid data format
+			FORMAT_ERROR,	//!< Invalid data format
+			IO_ERROR	//!< Error while reading or writing a file
 			} code;	//!< Code of the error
 		std::string message;	//!< Message describing the error
 		SudokuException(Code pcode):code(pcode) {}	//!< Standard constructor, without any error message
@@ -47,6 +55,23 @@ class SudokuException:public std::exception {
 		const char* what() const throw();	//!< Returns the nature of the error
 };
 
+/**
+ * \brief Element of the Luby sequence
+ *
+ * The Luby sequence 1,1,2,1,1,2,4,1,1,2,1,1,2,4,8... gives the lengths of the successive runs of a search with restarts. It is within a logarithmic factor of the optimal restart strategy when the distribution of the running times is unknown.
+ * \param x Index of the element, starting with 0
+ * \return Element of the sequence
+ */
+size_t luby(size_t x);
+
+/**
+ * \brief Seed for a random generator
+ *
+ * This function draws a seed from the random device of the system. It can be called from several threads.
+ * \return Random seed
+ */
+unsigned random_seed();
+
 /**
  * \brief Alternative for placement of an element in a Grid
  *
@@ -64,7 +89,7 @@ class Alternative {
 		 */
 		Alternative(size_t ptype,size_t pset,elem_t pvalue):type(ptype),set(pset),value(pvalue) {}
 
-		size_t type;	//!< Type of set this alternative refers to, 0 for a row, 1 for a column, 2 for an inner square
+		size_t type;	//!< Type of set this alternative refers to, 0 for a row, 1 for a column, 2 for a region (inner square), 3 for a diagonal
 		size_t set;	//!< Index of set this alternative refers to, first is 0
 		elem_t value;	//!< Value to be inserted in the grid
 };
@@ -138,7 +163,7 @@ class Grid {
 		 */
 		struct SuCoordinates {
 			SuCoordinates(size_t ptype,size_t pset,size_t pindex):type(ptype),set(pset),index(pindex) {}
-			size_t type;	//!< Type of the set, 0 for row, 1 for column, 2 for inner square
+			size_t type;	//!< Type of the set, 0 for row, 1 for column, 2 for region (inner square), 3 for diagonal
 			size_t set;	//!< First coordinate, index of the set (starting with 0)
 			size_t index;	//!< Second coordinate, index of the element in the set (starting with 0)
 		};
@@ -153,10 +178,46 @@ class Grid {
 			FIND_ALL	//!< Find all solutions matching the grid and list them
 		};
 
+		/**
+		 * \brief Rating of the difficulty of a puzzle by the effort of the solver
+		 *
+		 * The rating tells which deductions are needed to solve the puzzle and, when they are not enough, how big the search proving that the solution is unique is.
+		 */
+		struct Rating {
+			/**
+			 * \brief Deductions needed to solve a puzzle
+			 */
+			enum Level {
+				NAKED_SINGLES,	//!< Cells with a single possible value are enough
+				HIDDEN_SINGLES,	//!< Values with a single place left in a set are needed too
+				SEARCH	//!< Hypotheses are needed
+			} level;	//!< Deductions needed to solve the puzzle
+			size_t nodes;	//!< Number of hypotheses tried by the search proving the uniqueness of the solution, 0 if no search is needed
+			size_t depth;	//!< Largest number of nested hypotheses of the search
+			size_t score() const {return level+nodes+depth;}	//!< Combined score, increasing with the difficulty. It is 0 or 1 when no hypothesis is needed.
+		};
+
+		/**
+		 * \brief Estimate of the size of a search
+		 *
+		 * The errors are the half-widths of the 95% confidence intervals, computed from the variance of the probes. The distribution of the probes is heavy-tailed on irregular trees, so that the intervals are optimistic when few probes have been made.
+		 */
+		struct Estimate {
+			size_t probes;	//!< Number of random probes made
+			double nodes;	//!< Estimated number of hypotheses of the search for all the solutions
+			double nodes_error;	//!< Error of the number of hypotheses
+			double solutions;	//!< Estimated number of solutions
+			double solutions_error;	//!< Error of the number of solutions
+			double seconds;	//!< Estimated time of the search, from the time spent in each call during the probes
+			std::vector<double> profile;	//!< Estimated number of hypotheses at each depth, starting with depth 1. The element of index d-1 is the number of units given by Grid::split with depth d, solutions above excluded.
+		};
+
+		static const size_t placed=(size_t)-1;	//!< Level of an alternative whose value is already placed in the set
+
 		/**
 		 * \brief Warp coordinates from (row,column) to (set,index)
 		 *
-		 * This function calculates the coordinates in the (set,index) base.
+		 * This function calculates the coordinates in the (set,index) base. For a diagonal, the cell must lie on one of the diagonals of the grid.
 		 * \param type Type of set expected, see also SuCoordinates::type
 		 * \return Coordinates in the Sudoku base
 		 */
@@ -178,13 +239,32 @@ class Grid {
 		 */
 		Grid(size_t pdim=0);
 
+		/**
+		 * \brief Constructor from a geometry
+		 *
+		 * The constructor allocates memory for an empty grid with the given units, for example a jigsaw grid or a grid with diagonals. See Geometry for the available geometries.
+		 * \param pgeometry Geometry of the grid
+		 */
+		explicit Grid(std::shared_ptr<const Geometry> pgeometry);
+
 		/**
 		 * \brief Constructor from a stream
 		 *
 		 * The constructor creates a new grid by reading it from an input stream. See Grid::read_from_stream for more details about the format of the input stream.
 		 * \param pin Input stream
+		 * \param pgeometry Geometry of the grid, or a null pointer to deduce it from the dimension of the grid
 		 */
-		Grid(std::istream &pin);
+		Grid(std::istream &pin,std::shared_ptr<const Geometry> pgeometry=std::shared_ptr<const Geometry>());
+
+		/**
+		 * \brief Constructor from a packed buffer
+		 *
+		 * The constructor creates a new grid from its packed representation, as written by Grid::write_packed. The buffer holds one byte per cell, row by row, with 0 for an empty cell.
+		 * \param pdim Dimension of the grid
+		 * \param packed Buffer holding the values of the cells, its size must be at least Grid::_dim2*Grid::_dim2
+		 * \param pfixed Tell if the values read from the buffer are fixed or chosen by the user, default is true (fixed)
+		 */
+		Grid(size_t pdim,const unsigned char *packed,bool pfixed=true);
 
 		/**
 		 * \brief Copy constructor
@@ -194,6 +274,14 @@ class Grid {
 		 */
 		Grid(const Grid &source);
 
+		/**
+		 * \brief Move constructor
+		 *
+		 * The move constructor creates a new grid by taking over the arrays of the source grid, without copying them. The source grid is left empty, with dimension 0.
+		 * \param source Source grid
+		 */
+		Grid(Grid &&source) noexcept;
+
 		/**
 		 * \brief Standard destructor
 		 *
@@ -229,8 +317,8 @@ class Grid {
 		 * \brief Accessor of a cell through set number
 		 *
 		 * This method returns a pointer to a cell in the grid. The cell is located by its set type, its set index and its index in the set.
-		 * \param ptype Type of the set, 0 for a row set, 1 for a column set, 2 for an inner square set
-		 * \param pset Index of the set. Rows are numbered from 0 from top to bottom. Columns are numbered from 0 from left to right. Inner squares are numbered from 0, from left to right then top to bottom.
+		 * \param ptype Type of the set, 0 for a row set, 1 for a column set, 2 for a region set, 3 for a diagonal set
+		 * \param pset Index of the set. Rows are numbered from 0 from top to bottom. Columns are numbered from 0 from left to right. Inner squares are numbered from 0, from left to right then top to bottom. See Geometry for the other sets.
 		 * \param pindex Index of the cell in the set. First cell has index 0. Cells are numbered the same way as sets.
 		 * \return Pointer to the cell at the given coordinates
 		 */
@@ -239,19 +327,31 @@ class Grid {
 		/**
 		 * \brief Copy an other grid into the current one
 		 *
-		 * The overloaded operator copies all fields from a source grid into the current one. The copy is in depth, which means that all the arrays are copied into the object.
+		 * The overloaded operator copies all fields from a source grid into the current one. The copy is in depth, which means that all the arrays are copied into the object. The arrays previously held by the object are released.
 		 * \param source Source grid
+		 * \return Reference to the current grid
 		 */
-		void operator=(const Grid &source);
+		Grid& operator=(const Grid &source);
+
+		/**
+		 * \brief Move an other grid into the current one
+		 *
+		 * The overloaded operator releases the arrays held by the object and takes over the arrays of the source grid, without copying them. The source grid is left empty, with dimension 0.
+		 * \param source Source grid
+		 * \return Reference to the current grid
+		 */
+		Grid& operator=(Grid &&source) noexcept;
 
 		/**
 		 * \brief Read a grid from a stream
 		 *
 		 * The method reads a grid from a stream. Each line of the stream holds one row of the grid. Elements in columns are separated by whitespaces. The dimension of the grid is detected by the number of elements in the first line.
+		 * If no geometry is given, the grid is a standard one when the number of rows is a square integer. Otherwise its regions are the rectangular boxes with the most square shape, with fewer rows than columns (2x3 for a 6x6 grid, 3x4 for a 12x12 grid).
 		 * If the object already holds a grid when the method is called, the current grid is deleted.
 		 * \param in Input stream
+		 * \param pgeometry Geometry of the grid, or a null pointer to deduce it from the dimension of the grid
 		 */
-		void read_from_stream(std::istream &in);
+		void read_from_stream(std::istream &in,std::shared_ptr<const Geometry> pgeometry=std::shared_ptr<const Geometry>());
 
 		/**
 		 * \brief Write a grid to a stream
@@ -262,10 +362,35 @@ class Grid {
 		void write_to_stream(std::ostream &out) const;
 		void write_to_cout() const {write_to_stream(std::cout);std::cout << std::endl;}
 
+		/**
+		 * \brief Read a grid written on a single line
+		 *
+		 * The line holds one character per cell, row by row: '1' to '9' for the values 1 to 9, 'A' to 'Z' for the values 10 to 35, and '0' or '.' for an empty cell. The dimension of the grid is the square root of the length of the line. This is the usual format of the collections of puzzles.
+		 * The geometry is chosen as in Grid::read_from_stream. The method throws a SudokuException if the line is not valid.
+		 * \param line Line holding the grid
+		 * \param pgeometry Geometry of the grid, or a null pointer to deduce it from the dimension of the grid
+		 */
+		void read_line(const std::string &line,std::shared_ptr<const Geometry> pgeometry=std::shared_ptr<const Geometry>());
+
+		/**
+		 * \brief Write a grid on a single line
+		 *
+		 * \return Line holding the grid in the format read by Grid::read_line, with '.' for the empty cells
+		 */
+		std::string write_line() const;
+
+		/**
+		 * \brief Write a grid to a packed buffer
+		 *
+		 * The method writes the values of the grid in a compact binary form, one byte per cell, row by row. Empty cells are written as 0. This is the format used by the puzzle bank and it can be read back with the corresponding constructor.
+		 * \param packed Buffer receiving the values, its size must be at least Grid::_dim2*Grid::_dim2
+		 */
+		void write_packed(unsigned char *packed) const;
+
 		/**
 		 * \brief Accessor to the dimension of the grid
 		 *
-		 * This method returns the dimension of the grid, which is the square root of the number of rows (or columns)
+		 * This method returns the dimension of the grid, which is the square root of the number of rows (or columns). For grids whose number of rows is not a square, it is rounded down.
 		 * \return Dimension of the grid
 		 */
 		size_t dim() const {return _dim;}
@@ -278,6 +403,22 @@ class Grid {
 		 */
 		size_t dim2() const {return _dim2;}
 
+		/**
+		 * \brief Accessor to the geometry of the grid
+		 *
+		 * This method returns the tables describing the units and the peers of the cells of the grid.
+		 * \return Geometry of the grid
+		 */
+		const Geometry& geometry() const {return *_geometry;}
+
+		/**
+		 * \brief Accessor to the shared geometry of the grid
+		 *
+		 * This method returns the shared pointer to the geometry, which can be used to create other grids with the same units.
+		 * \return Shared geometry of the grid
+		 */
+		std::shared_ptr<const Geometry> shared_geometry() const {return _geometry;}
+
 		/**
 		 * \brief Set the value of a cell
 		 *
@@ -290,6 +431,49 @@ class Grid {
 		 */
 		void set_value(size_t prow,size_t pcolumn,elem_t pvalue,bool pfixed=false);
 
+		/**
+		 * \brief Erase the value of a cell
+		 *
+		 * This function erases the value of the selected cell and restores the underlying structures used by the resolution algorithm, as if the value had never been set. The possible values of the cell are computed again from its peers, the erased value becomes possible again in the peers which do not see it elsewhere, and the levels of the alternatives of the affected sets are counted again.
+		 * The cost of the function only depends on the number of peers of the cell, so it can be used interactively. It also works when the grid holds conflicting values.
+		 * \param prow Row index of the cell to be erased
+		 * \param pcolumn Column index of the cell to be erased
+		 */
+		void unset_value(size_t prow,size_t pcolumn);
+
+		/**
+		 * \brief List the peers of a cell
+		 *
+		 * This method lists the cells sharing a unit (row, column, region or diagonal) with the given cell. Each peer is listed once and the cell itself is not listed.
+		 * \param prow Row index of the cell
+		 * \param pcolumn Column index of the cell
+		 * \return Coordinates of the peers of the cell
+		 */
+		std::vector<XYCoordinates> peers(size_t prow,size_t pcolumn) const;
+
+		/**
+		 * \brief Count the conflicts of a cell
+		 *
+		 * This method counts the peers of the cell which hold the same value.
+		 * \param prow Row index of the cell
+		 * \param pcolumn Column index of the cell
+		 * \return Number of peers holding the value of the cell, 0 if the cell is empty
+		 */
+		size_t conflicts(size_t prow,size_t pcolumn) const;
+
+		/**
+		 * \brief Find a value which can be deduced from the current state
+		 *
+		 * This method looks for an empty cell whose value is forced by the current state of the grid, either because it has only one possible value left, or because it is the only place left for a value in one of its sets. It does not solve the grid and it runs in a time proportional to the size of the grid.
+		 * If the solution of the grid is known, the values of the grid are checked against it first, and the first cell holding a wrong value is returned instead, as nothing can be deduced safely from a wrong value.
+		 * \param prow Row index of the cell found
+		 * \param pcolumn Column index of the cell found
+		 * \param pvalue Value which must be placed in the cell
+		 * \param psolution Solution of the grid, or null pointer if it is not known
+		 * \return True if such a cell has been found, false otherwise
+		 */
+		bool hint(size_t &prow,size_t &pcolumn,elem_t &pvalue,const Grid *psolution=0) const;
+
 		/**
 		 * \brief Construct an alternative from an index
 		 *
@@ -304,7 +488,7 @@ class Grid {
 		/**
 		 * \brief Get the level of an alternative
 		 *
-		 * This method gets the level of an alternative at the given position. The level is the number of choices for the placement of the value held by the alternative in the grid.
+		 * This method gets the level of an alternative at the given position. The level is the number of choices for the placement of the value held by the alternative in the grid. It is Grid::placed if the value is already placed in the set, and 0 if the value cannot be placed anywhere in the set.
 		 * \param ptype Type of set referred by the alternative
 		 * \param pset Index of set referred by the alternative
 		 * \param pvalue Value of the alternative
@@ -339,45 +523,332 @@ class Grid {
 		 */
 		size_t solve(SolveType type=FIND_ONE,std::function<void(const Grid&)> callback=&Grid::write_to_cout) const;
 
+		/**
+		 * \brief Enumerate the solutions of the grid with checkpoints
+		 *
+		 * This method lists all the solutions of the grid like Grid::solve with FIND_ALL, in the same order. The search is identified at any time by its path, the index of the branch followed at each hypothesis from the top of the search tree. The branches on the left of the path have been fully explored, and the branches on the right have not been started. The checkpoint function is called with the path, before a branch is started, once at least period seconds have passed since the last call. A later search started with this path in resume skips the explored branches and goes on with the same solutions, in the same order, as the interrupted one.
+		 * \param callback Callback function applied on each solution grid
+		 * \param checkpoint Function called periodically with the path of the search and the number of hypotheses tried, it may be empty
+		 * \param period Minimal number of seconds between two calls of the checkpoint function
+		 * \param resume Path where the search starts, given by the checkpoint function of an interrupted search with the same grid, or empty vector to start from the beginning
+		 * \return Number of solutions found, excluding the ones found before the path given in resume
+		 */
+		size_t enumerate(std::function<void(const Grid&)> callback,std::function<void(const std::vector<size_t>&,size_t)> checkpoint,double period,const std::vector<size_t> &resume=std::vector<size_t>()) const;
+
+		/**
+		 * \brief Enumerate the solutions of the grid within a limit
+		 *
+		 * This method lists the solutions of the grid like Grid::solve with FIND_ALL, in the same order, but it stops when a number of hypotheses have been tried.
+		 * \param callback Callback function applied on each solution grid
+		 * \param maxnodes Number of hypotheses after which the search is aborted, 0 for no limit
+		 * \param nsolutions Variable receiving the number of solutions found
+		 * \return True if all the solutions have been found, false if the search has been aborted
+		 */
+		bool enumerate(std::function<void(const Grid&)> callback,size_t maxnodes,size_t &nsolutions) const;
+
+		/**
+		 * \brief Enumerate the solutions of the grid up to a permutation of values
+		 *
+		 * This method lists the solutions of the grid like Grid::solve with FIND_ALL, but it only lists one solution of each class of solutions which only differ by a permutation of the interchangeable values. Such values must appear neither in the grid nor in a cage: two of them can then be exchanged in any solution to get another one.
+		 * The search breaks the symmetry as it goes: when a cell is branched on, only the smallest of the interchangeable values which have not been placed yet is tried, and the places of these values in a set are never branched on. Each class is therefore found once, and it holds k! solutions for k interchangeable values, since all the values appear in a full grid.
+		 * \param callback Callback function applied on each solution grid
+		 * \param interchangeable Tell for each value, at index v-1 for value v, if it is interchangeable
+		 * \return Number of solutions found, one for each class
+		 */
+		size_t enumerate(std::function<void(const Grid&)> callback,const std::vector<bool> &interchangeable) const;
+
+		/**
+		 * \brief Split the search for the solutions of the grid
+		 *
+		 * This method expands the top levels of the search tree of Grid::solve. Each branch started at the given depth is cut and its grid, with the value of the hypothesis set, is handed to the unit function instead of being explored. The solutions found above this depth are handed too, as full grids. The solutions of the grid are the union of the solutions of the units, with no unit sharing a solution with another one, and the units come in the order of their solutions in Grid::solve.
+		 * \param depth Number of hypotheses above the units, 0 to get the grid itself
+		 * \param unit Function called on each unit
+		 * \return Number of units
+		 */
+		size_t split(size_t depth,std::function<void(const Grid&)> unit) const;
+
+		/**
+		 * \brief Find any solution with a portfolio of searches
+		 *
+		 * This method looks for any solution of the grid, as Grid::solve with FIND_ANY, but it runs several randomized searches in parallel threads. Each search is restarted with a new random order of branches after a number of hypotheses following the Luby sequence, and the searches use different units for this sequence. The first solution found by any of the searches is kept and all the others are cancelled.
+		 * A single randomized search has a heavy-tailed running time on large grids, because an early bad choice can trap it in a big subtree without solution. Restarts and parallel searches cut this tail. When the number of searches is chosen automatically, a single search is first run on the calling thread, until its end for the grids of at most 9 values and within a short budget of hypotheses for the others, and the threads are only started if this search runs out of budget.
+		 * \param callback Callback function applied on the solution found
+		 * \param nthreads Number of parallel searches, 0 to try a single search first and then use the number of processors
+		 * \param stop Flag which can be set by another thread to cancel the search, or null pointer
+		 * \return 1 if a solution has been found, 0 if the grid has no solution or if the search has been cancelled
+		 */
+		size_t solve_portfolio(std::function<void(const Grid&)> callback=&Grid::write_to_cout,size_t nthreads=0,const std::atomic<bool> *stop=0) const;
+
 		/**
 		 * \brief Fill the grid
 		 *
-		 * This method is a wrapper to the Grid::solve method. It tries to fill the grid by looking at any solution and updates the grid to this solution if it is found.
-		 * \return True if the grid could be filled, false otherwise
+		 * This method is a wrapper to the Grid::solve_portfolio method. It tries to fill the grid by looking at any solution and updates the grid to this solution if it is found.
+		 * \param stop Flag telling the search to abort as soon as possible, null pointer if the search cannot be cancelled
+		 * \return True if the grid could be filled, false otherwise or if the search has been cancelled
+		 */
+		bool fill(const std::atomic<bool> *stop=0);
+
+		/**
+		 * \brief Build a random full grid
+		 *
+		 * This static method creates a full valid grid without searching, for the geometries whose regions are rectangular boxes, without diagonals or cages. A seed solution is taken from a pool kept for each geometry, which starts with a pattern grid and is renewed by random exchanges of values between two rows or two columns of the same band or stack. Random transformations keeping the grid valid are then applied to the seed: relabelling of the values, permutations of the bands, of the stacks, of the rows inside each band and of the columns inside each stack, and transposition if the boxes are square. Each transformation is drawn uniformly. For the other geometries, the grid is filled by Grid::fill.
+		 * \param pgeometry Geometry of the new grid
+		 * \param stop Flag telling the search to abort as soon as possible, null pointer if it cannot be cancelled. It is only used if a search is needed.
+		 * \return New full grid, or empty grid (with Grid::dim2 equal to 0) if the search has been cancelled
 		 */
-		bool fill();
+		static Grid synthesize(std::shared_ptr<const Geometry> pgeometry,const std::atomic<bool> *stop=0);
 
 		/**
 		 * \brief Generate a game grid
 		 *
-		 * This static method creates a Sudoku grid for a game. For the highest level of difficulty, a minimal number of elements are placed so that the grid only has one solution.
-		 * For lower levels of difficulty, new elements are added randomly.
+		 * This static method creates a Sudoku grid for a game. A full valid grid is created first by Grid::synthesize, then clues are removed from it by Grid::dig as long as the solution stays unique.
+		 * For the highest level of difficulty, a minimal number of elements are left so that the grid only has one solution. For lower levels of difficulty, the removal stops earlier.
 		 * \param dimension Dimension of the new grid (number of cells on one row of an inner square)
 		 * \param difficulty Level of difficulty, between 0 (hardest) and (Grid::_dim2-Grid::_dim)*Grid::_dim2 (easiest). The minimum number of elements provided for a generated grid is Grid::_dim2*Grid::_dim+difficulty.
 		 * \param solution If the pointer is not null, it must point to an allocated Grid, and the solution of the game is stored there.
+		 * \param symmetric Tell if the clues of the grid must be symmetric with respect to the center of the grid, default is false
 		 * \return New game grid
 		 */
-		static Grid generate(size_t dimension,size_t difficulty,Grid *solution=0);
+		static Grid generate(size_t dimension,size_t difficulty,Grid *solution=0,bool symmetric=false);
+
+		/**
+		 * \brief Generate a game grid with a given geometry
+		 *
+		 * This static method works as the previous one, for any geometry of grid. The minimum number of elements provided is Grid::_dim2*Grid::_dim+difficulty, with the nominal dimension of the geometry.
+		 * \param pgeometry Geometry of the new grid
+		 * \param difficulty Level of difficulty
+		 * \param solution If the pointer is not null, it must point to an allocated Grid, and the solution of the game is stored there.
+		 * \param symmetric Tell if the clues of the grid must be symmetric with respect to the center of the grid, default is false
+		 * \param stop Flag telling the generation to abort as soon as possible, null pointer if it cannot be cancelled. It is checked between two hypotheses of the searches, so that the generation can be run in a background thread.
+		 * \return New game grid, or empty grid (with Grid::dim2 equal to 0) if the generation has been cancelled
+		 */
+		static Grid generate(std::shared_ptr<const Geometry> pgeometry,size_t difficulty,Grid *solution=0,bool symmetric=false,const std::atomic<bool> *stop=0);
+
+		/**
+		 * \brief Create a game grid by removing clues from a full grid
+		 *
+		 * This static method starts from a full valid grid and tries to remove its clues one by one in a random order. A clue is removed only if the grid keeps a unique solution. The uniqueness test looks for a solution holding another value in the removed cell, and stops at the first one it finds.
+		 * The grid is updated incrementally with Grid::unset_value and Grid::set_value, so the propagated state is kept from one step to the next and each test starts from a copy of it instead of reading the clues again.
+		 * Since removing clues can only add solutions, a clue which cannot be removed at some step will never be removable later. When the minimum number of clues is 0, all the clues are tested once and the result is a minimal grid, where no clue is redundant.
+		 * \param solution Full valid grid used as the solution of the game
+		 * \param minclues Number of clues under which the removal stops, 0 to get a minimal grid
+		 * \param symmetric Tell if the clues must be removed by pairs of cells symmetric with respect to the center of the grid, default is false. In this case, the grid is minimal among symmetric grids.
+		 * \param stop Flag telling the removal to abort as soon as possible, null pointer if it cannot be cancelled
+		 * \return New game grid, all its values are fixed, or empty grid (with Grid::dim2 equal to 0) if the removal has been cancelled
+		 */
+		static Grid dig(const Grid &solution,size_t minclues=0,bool symmetric=false,const std::atomic<bool> *stop=0);
+
+		/**
+		 * \brief Estimate the size of the search for all the solutions
+		 *
+		 * This method uses the random probes of Knuth. A probe follows the search of Grid::solve from the top, with the same deductions, but it follows a single branch drawn at random at each hypothesis, until a solution or a dead end. The product of the numbers of branches met on the way is the weight of the probe: the number of branches at each depth multiplied by the weight above it is an unbiased estimate of the number of hypotheses at this depth, and the weight of a probe ending with a solution is an unbiased estimate of the number of solutions. The probes are repeated until the time budget is spent and their results are averaged.
+		 * \param seconds Time budget of the estimation
+		 * \param maxprobes Number of probes after which the estimation stops before the end of its budget, 0 for no limit
+		 * \return Estimate of the search, based on at least one probe
+		 */
+		Estimate estimate(double seconds,size_t maxprobes=0) const;
+
+		/**
+		 * \brief Rate the difficulty of the grid
+		 *
+		 * This method applies the deductions on a copy of the grid, first the cells with a single possible value, then the values with a single place left in a set, and searches the remaining grid with FIND_UNIQUE if they are not enough. The rating stops as soon as its score is known to be above the limit: the search is not started if the level alone exceeds it, and it is aborted once it has tried more hypotheses than the limit.
+		 * \param rating Variable receiving the rating, it is only complete if the method returns true
+		 * \param maxscore Highest score accepted
+		 * \param stop Flag telling the search to abort as soon as possible, null pointer if it cannot be cancelled
+		 * \return True if the score of the grid is at most maxscore, false if it is above or if the search has been cancelled
+		 */
+		bool rate(Rating &rating,size_t maxscore=std::numeric_limits<size_t>::max(),const std::atomic<bool> *stop=0) const;
+
+		/**
+		 * \brief Generate a game grid in a band of difficulty
+		 *
+		 * This static method creates a game grid whose score, as given by Grid::rate, lies between minscore and maxscore. Clues are removed from a full grid as in Grid::dig, and the grid is rated after each removal. The removal goes on through all the cells, and a removal which takes the score out of the band is undone right away: above the band at any time, the rating being aborted at the limit, and below the band once it has been entered. The grid is then a puzzle of the band from which no clue can be removed without leaving the band. A full grid whose minimal puzzle stays below the band is rejected and another one is synthesized.
+		 * \param pgeometry Geometry of the new grid
+		 * \param minscore Lowest score of the grid
+		 * \param maxscore Highest score of the grid
+		 * \param rating If the pointer is not null, the rating of the grid is stored there
+		 * \param solution If the pointer is not null, it must point to an allocated Grid, and the solution of the game is stored there
+		 * \param symmetric Tell if the clues of the grid must be symmetric with respect to the center of the grid, default is false
+		 * \param stop Flag telling the generation to abort as soon as possible, null pointer if it cannot be cancelled
+		 * \param ncandidates If the pointer is not null, the number of full grids tried is stored there
+		 * \return New game grid, or empty grid (with Grid::dim2 equal to 0) if the generation has been cancelled
+		 */
+		static Grid generate_rated(std::shared_ptr<const Geometry> pgeometry,size_t minscore,size_t maxscore,Rating *rating=0,Grid *solution=0,bool symmetric=false,const std::atomic<bool> *stop=0,size_t *ncandidates=0);
 
 	private:
-		size_t _dim;	//!< Dimension of the grid (number of rows, which is the same as the number of columns)
+		/**
+		 * \brief State of a search shared by all its recursive calls
+		 */
+		struct SearchContext {
+			SearchContext(std::mt19937 &pgenerator):generator(pgenerator),nodes(0),maxnodes(0),stop(0),aborted(false),depth(0),maxdepth(0),resume(0),checkpoint(0),period(0),unit(0),splitdepth(0),probe(false),weight(1),solutions(0),interchangeable(0) {}	//!< Standard constructor, for a search without limit
+			std::mt19937 &generator;	//!< Random generator used to choose the branches with FIND_ANY
+			size_t nodes;	//!< Number of hypotheses tried so far
+			size_t maxnodes;	//!< Number of hypotheses after which the search is aborted, 0 for no limit
+			const std::atomic<bool> *stop;	//!< Flag telling the search to abort as soon as possible, null pointer if the search cannot be cancelled
+			bool aborted;	//!< Tell if the search has been aborted before its end
+			size_t depth;	//!< Number of hypotheses above the current call, recorded in the trace
+			size_t maxdepth;	//!< Largest depth reached so far
+			std::vector<size_t> path;	//!< Index of the branch followed at each hypothesis above the current call, only kept if there is a checkpoint function
+			const std::vector<size_t> *resume;	//!< Path of the branches to follow again to resume a search, null pointer once it has been followed
+			const std::function<void(const std::vector<size_t>&,size_t)> *checkpoint;	//!< Function called periodically with the path of the search, null pointer if there is none
+			double period;	//!< Minimal number of seconds between two calls of the checkpoint function
+			std::chrono::steady_clock::time_point last;	//!< Time of the last call of the checkpoint function
+			const std::function<void(const Grid&)> *unit;	//!< Function receiving the branches cut by Grid::split, null pointer if the search is not split
+			size_t splitdepth;	//!< Depth of the branches cut by Grid::split
+			bool probe;	//!< Tell if the search is a random probe of Grid::estimate, following a single branch at each hypothesis
+			double weight;	//!< Product of the numbers of branches of the hypotheses above the current call, in a probe
+			std::vector<double> profile;	//!< Number of branches at each depth multiplied by the weight, in a probe
+			double solutions;	//!< Weight of the solution reached by a probe, 0 if it ends in a dead end
+			const std::vector<bool> *interchangeable;	//!< Values which can be exchanged in all the solutions, the one of index v-1 for value v, null pointer if the symmetric solutions are all listed
+		};
+
+		size_t _dim;	//!< Nominal dimension of the grid (square root of the number of rows, which is the same as the number of columns)
 		size_t _dim2;	//!< Square dimension of the grid, stored for quicker access
 		Cell **_cells;	//!< Array of cells in the grid. Cells of the grid are numbered row by row from top to bottom, and in each row column by column from left to right. The top-left cell has index 0.
 		size_t _filled;	//!< Number of values already set
+		size_t _broken;	//!< Number of full cages whose sum is wrong, the grid has no solution if it is not null
 		size_t *_alternatives;	//!< Array containing the levels of the alternatives (the number of choices for the placement of a value)
+		std::shared_ptr<const Geometry> _geometry;	//!< Tables of the units and peers of the cells, shared by all grids of the same geometry
+
+		/**
+		 * \brief Number of alternatives of the grid
+		 *
+		 * \return Size of the Grid::_alternatives array, one entry for each value in each unit
+		 */
+		size_t nalternatives() const {return _geometry?_geometry->nunits()*_dim2:0;}
 
-		static Grid _saved;	//!< Grid used to save the solution of the Grid::solve algorithm
+		/**
+		 * \brief Geometry of a grid read from a file
+		 *
+		 * The method throws a SudokuException if no geometry fits the dimension.
+		 * \param dim2 Number of rows of the grid
+		 * \return Standard geometry if the number of rows is a square integer, geometry with the most square rectangular boxes otherwise
+		 */
+		static std::shared_ptr<const Geometry> default_geometry(size_t dim2);
 
 		/**
-		 * \brief Save the grid in a static variable
+		 * \brief Allocate the cells and the alternatives of an empty grid
 		 *
-		 * This method is intended to be used as a callback function for the Grid::solve method. It simply saves the grid given as argument in a static variable, in order to make it accessible from other parts of the program.
-		 * The method Grid::fill uses this callback function.
-		 * \param source Source grid to save in the static variable
+		 * The method uses the geometry of the grid, the arrays must have been released before.
 		 */
-		void save() const;
-};
+		void allocate();
+
+		/**
+		 * \brief Solve the grid within a search
+		 *
+		 * This method does the work of Grid::solve. It checks the limits of the search before each hypothesis, and when one of them is reached it sets SearchContext::aborted and returns the number of solutions found so far.
+		 * \param type Type of solving
+		 * \param callback Callback function applied on each solution grid
+		 * \param context State of the search
+		 * \return Number of solutions found
+		 */
+		size_t solve(SolveType type,const std::function<void(const Grid&)> &callback,SearchContext &context) const;
+
+		/**
+		 * \brief Remove clues from a full grid
+		 *
+		 * This method does the work of Grid::dig. After each removal keeping the solution unique, the judge function, if it is not empty, is called on the grid: a negative result puts the removed clues back, a positive one stops the removal.
+		 * \param solution Full valid grid used as the solution of the game
+		 * \param minclues Number of clues under which the removal stops
+		 * \param symmetric Tell if the clues are removed by symmetric pairs
+		 * \param stop Flag telling the removal to abort as soon as possible, null pointer if it cannot be cancelled
+		 * \param judge Function called on the grid after each removal, may be empty
+		 * \return New game grid, or empty grid if the removal has been cancelled
+		 */
+		static Grid dig(const Grid &solution,size_t minclues,bool symmetric,const std::atomic<bool> *stop,const std::function<int(const Grid&)> &judge);
+
+		/**
+		 * \brief Apply the deductions on the grid
+		 *
+		 * The method places the values of the cells with a single possible value, and if hidden is true the values with a single place left in a set, until no deduction is possible.
+		 * \param hidden Tell if the values with a single place left in a set are placed too
+		 * \return True if the grid is full and the sums of its cages are right
+		 */
+		bool deduce(bool hidden);
+
+		/**
+		 * \brief Account for the branches of a hypothesis in a probe
+		 *
+		 * The method multiplies the weight of the probe by the number of branches and adds the result to the profile at the current depth.
+		 * \param context State of the probe
+		 * \param nbranches Number of branches of the hypothesis
+		 */
+		static void probe_branches(SearchContext &context,size_t nbranches);
+
+		/**
+		 * \brief Get the first branch of a hypothesis
+		 *
+		 * The method follows the path of SearchContext::resume while it is not exhausted, and forgets it when its last branch is reached.
+		 * \param context State of the search
+		 * \return Index of the first branch to try at the current depth, 0 for a search which is not being resumed
+		 */
+		static size_t first_branch(SearchContext &context);
+
+		/**
+		 * \brief Start a branch of a hypothesis
+		 *
+		 * The method records the branch in the path of the search and calls the checkpoint function if its period has passed.
+		 * \param context State of the search
+		 * \param branch Index of the branch at the current depth
+		 */
+		static void start_branch(SearchContext &context,size_t branch);
+
+		/**
+		 * \brief Tell if a value has been placed in the grid
+		 *
+		 * \param pvalue Value to look for
+		 * \return True if one of the cells holds the value
+		 */
+		bool is_placed(elem_t pvalue) const;
 
+		/**
+		 * \brief Tell if a value is seen by a cell
+		 *
+		 * \param pcell Index of the cell, see Geometry
+		 * \param pvalue Value to look for
+		 * \return True if one of the peers of the cell holds the value
+		 */
+		bool is_seen(size_t pcell,elem_t pvalue) const;
+
+		/**
+		 * \brief Restrict the possible values of the cells of a cage
+		 *
+		 * This method looks up the values allowed in the empty cells of the cage, from their number, the sum left and the union of their possible values (see Geometry::cage_mask), and removes the other values from the cells. It is repeated until the union does not change. It must be called again whenever a cell of the cage gets a value or loses a possible value.
+		 * \param pcage Index of the cage
+		 * \return False if the cage is full and the sum of its values is wrong
+		 */
+		bool restrict_cage(size_t pcage);
+
+		/**
+		 * \brief Remove a possible value of a cell
+		 *
+		 * The method updates the number of possible values of the cell and the levels of the alternatives of the sets containing it. The value must be possible in the cell.
+		 * \param pcell Index of the cell, see Geometry
+		 * \param pvalue Value removed
+		 */
+		void eliminate(size_t pcell,elem_t pvalue);
+
+		/**
+		 * \brief Count again the level of an alternative
+		 *
+		 * This method computes the level of an alternative from scratch, by looking at all the cells of the set. The level is Grid::placed if the value is already placed in the set.
+		 * \param punit Index of the unit referred by the alternative, see Geometry
+		 * \param pvalue Value of the alternative
+		 */
+		void count_alternative(size_t punit,elem_t pvalue);
+
+		/**
+		 * \brief Coordinates of a cell of a unit
+		 *
+		 * \param punit Index of the unit, see Geometry
+		 * \param pindex Index of the cell in the unit
+		 * \return Coordinates of the cell in the grid base
+		 */
+		XYCoordinates unit_cell(size_t punit,size_t pindex) const {
+			size_t c=_geometry->unit(punit)[pindex];
+			return XYCoordinates(c/_dim2,c%_dim2);
+		}
+};
 
 /**
  * \brief Reads a full Sudoku grid from an input stream
@@ -0,0 +1,515 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sat.cpp
+ *
+ *    Description:  Implementation of the clause-learning solving backend
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 15:47:09
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
+#include "sat.h"
+
+using namespace std;
+
+const uint32_t SatSolver::binary;
+const uint32_t SatSolver::noreason;
+const uint32_t SatSolver::binaryconflict;
+
+/**************************************************************************/
+/*                              SatSolver                                 */
+/**************************************************************************/
+
+SatSolver::SatSolver():_ok(true),_qhead(0),_varinc(1),_clainc(1),_nlearnts(0),_maxlearnts(0),_nconflicts(0),_ndecisions(0),_npropagations(0),_nrestarts(0) {
+}
+
+int SatSolver::new_variable() {
+	int v=_assigns.size();
+	_assigns.push_back(0);
+	_polarity.push_back(1);
+	_level.push_back(0);
+	_reason.push_back(noreason);
+	_activity.push_back(0);
+	_heapindex.push_back(-1);
+	_seen.push_back(0);
+	_watches.resize(2*_assigns.size());
+	heap_insert(v);
+	return v+1;
+}
+
+bool SatSolver::add_clause(const vector<int> &clause) {
+	if (!_ok) return false;
+	cancel_until(0);
+	vector<uint32_t> lits;
+	for (int l:clause) lits.push_back(l>0?2*(l-1):2*(-l-1)+1);
+	sort(lits.begin(),lits.end());
+	vector<uint32_t> simplified;
+	for (size_t i=0;i<lits.size();++i) {
+		if (i>0 && lits[i]==lits[i-1]) continue;
+		if (lit_value(lits[i])>0 || (i>0 && lits[i]==(lits[i-1]^1))) return true;	// Clause already satisfied or tautology
+		if (lit_value(lits[i])==0) simplified.push_back(lits[i]);
+	}
+	if (simplified.empty()) return _ok=false;
+	if (simplified.size()==1) {
+		assign(simplified[0],noreason);
+		return _ok=(propagate()==noreason);
+	}
+	if (simplified.size()==2) attach_binary(simplified[0],simplified[1]);
+	else {
+		_clauses.push_back(Clause{simplified,false,0});
+		attach(_clauses.size()-1);
+	}
+	return true;
+}
+
+void SatSolver::assign(uint32_t lit,uint32_t reason) {
+	int v=lit>>1;
+	_assigns[v]=(lit&1)?-1:1;
+	_level[v]=decision_level();
+	_reason[v]=reason;
+	_trail.push_back(lit);
+}
+
+void SatSolver::attach(uint32_t index) {
+	const vector<uint32_t> &lits=_clauses[index].lits;
+	_watches[lits[0]].push_back(Watcher{index,lits[1]});
+	_watches[lits[1]].push_back(Watcher{index,lits[0]});
+}
+
+void SatSolver::attach_binary(uint32_t a,uint32_t b) {
+	_watches[a].push_back(Watcher{binary,b});
+	_watches[b].push_back(Watcher{binary,a});
+}
+
+uint32_t SatSolver::propagate() {
+	while (_qhead<_trail.size()) {
+		uint32_t falselit=_trail[_qhead++]^1;
+		++_npropagations;
+		vector<Watcher> &ws=_watches[falselit];
+		size_t i=0,j=0;
+		while (i<ws.size()) {
+			Watcher w=ws[i++];
+			signed char b=lit_value(w.blocker);
+			if (b>0) {
+				ws[j++]=w;
+				continue;
+			}
+			if (w.reason==binary) {	// Binary clause, the other literal is the blocker
+				ws[j++]=w;
+				if (b<0) {
+					_conflict[0]=falselit;
+					_conflict[1]=w.blocker;
+					while (i<ws.size()) ws[j++]=ws[i++];
+					ws.resize(j);
+					_qhead=_trail.size();
+					return binaryconflict;
+				}
+				assign(w.blocker,binary | falselit);
+				continue;
+			}
+			vector<uint32_t> &lits=_clauses[w.reason].lits;
+			if (lits[0]==falselit) swap(lits[0],lits[1]);
+			uint32_t first=lits[0];
+			if (first!=w.blocker && lit_value(first)>0) {
+				ws[j++]=Watcher{w.reason,first};
+				continue;
+			}
+			// Look for a new literal to watch
+			bool found=false;
+			for (size_t k=2;k<lits.size();++k) if (lit_value(lits[k])>=0) {
+				lits[1]=lits[k];
+				lits[k]=falselit;
+				_watches[lits[1]].push_back(Watcher{w.reason,first});
+				found=true;
+				break;
+			}
+			if (found) continue;
+			// The clause is unit or conflicting
+			ws[j++]=Watcher{w.reason,first};
+			if (lit_value(first)<0) {
+				while (i<ws.size()) ws[j++]=ws[i++];
+				ws.resize(j);
+				_qhead=_trail.size();
+				return w.reason;
+			}
+			assign(first,w.reason);
+		}
+		ws.resize(j);
+	}
+	return noreason;
+}
+
+const uint32_t *SatSolver::reason_lits(uint32_t reason,uint32_t lit,uint32_t *tmp,size_t &n) const {
+	if (reason==binaryconflict) {
+		n=2;
+		return _conflict;
+	}
+	if (reason & binary) {
+		tmp[0]=lit;
+		tmp[1]=reason & ~binary;
+		n=2;
+		return tmp;
+	}
+	n=_clauses[reason].lits.size();
+	return &_clauses[reason].lits[0];
+}
+
+size_t SatSolver::analyze(uint32_t conflict,vector<uint32_t> &learnt) {
+	learnt.clear();
+	learnt.push_back(0);
+	size_t pathc=0;
+	uint32_t p=noreason;
+	uint32_t tmp[2];
+	size_t index=_trail.size();
+	// Resolve the conflict with the reasons of the literals of the current level, until only one of them is left
+	do {
+		if (conflict<binary && _clauses[conflict].learnt) bump_clause(_clauses[conflict]);
+		size_t n;
+		const uint32_t *lits=reason_lits(conflict,p,tmp,n);
+		for (size_t j=(p==noreason)?0:1;j<n;++j) {
+			int v=lits[j]>>1;
+			if (!_seen[v] && _level[v]>0) {
+				bump_variable(v);
+				_seen[v]=1;
+				if (_level[v]>=decision_level()) ++pathc; else learnt.push_back(lits[j]);
+			}
+		}
+		while (!_seen[_trail[--index]>>1]);
+		p=_trail[index];
+		conflict=_reason[p>>1];
+		_seen[p>>1]=0;
+		--pathc;
+	} while (pathc>0);
+	learnt[0]=p^1;
+	// Remove the literals implied by other literals of the clause
+	vector<uint32_t> marked(learnt.begin()+1,learnt.end());
+	size_t k=1;
+	for (size_t i=1;i<learnt.size();++i) {
+		uint32_t r=_reason[learnt[i]>>1];
+		bool keep=(r==noreason);
+		if (!keep) {
+			size_t n;
+			const uint32_t *lits=reason_lits(r,learnt[i]^1,tmp,n);
+			for (size_t j=1;j<n && !keep;++j) if (!_seen[lits[j]>>1] && _level[lits[j]>>1]>0) keep=true;
+		}
+		if (keep) learnt[k++]=learnt[i];
+	}
+	learnt.resize(k);
+	for (uint32_t l:marked) _seen[l>>1]=0;
+	// Find the backjump level, the highest level of the other literals
+	if (learnt.size()==1) return 0;
+	size_t m=1;
+	for (size_t i=2;i<learnt.size();++i) if (_level[learnt[i]>>1]>_level[learnt[m]>>1]) m=i;
+	swap(learnt[1],learnt[m]);
+	return _level[learnt[1]>>1];
+}
+
+void SatSolver::cancel_until(size_t level) {
+	if (decision_level()<=level) return;
+	for (size_t i=_trail.size();i>_traillim[level];--i) {
+		int v=_trail[i-1]>>1;
+		_polarity[v]=_trail[i-1]&1;
+		_assigns[v]=0;
+		if (_heapindex[v]<0) heap_insert(v);
+	}
+	_trail.resize(_traillim[level]);
+	_traillim.resize(level);
+	_qhead=_trail.size();
+}
+
+void SatSolver::bump_variable(int var) {
+	if ((_activity[var]+=_varinc)>1e100) {
+		for (auto &a:_activity) a*=1e-100;
+		_varinc*=1e-100;
+	}
+	if (_heapindex[var]>=0) heap_up(_heapindex[var]);
+}
+
+void SatSolver::bump_clause(Clause &clause) {
+	if ((clause.activity+=_clainc)>1e20) {
+		for (auto &c:_clauses) if (c.learnt) c.activity*=1e-20;
+		_clainc*=1e-20;
+	}
+}
+
+void SatSolver::reduce_learnts() {
+	vector<uint32_t> learnts;
+	for (uint32_t i=0;i<_clauses.size();++i) if (_clauses[i].learnt) learnts.push_back(i);
+	sort(learnts.begin(),learnts.end(),[this](uint32_t a,uint32_t b) {return _clauses[a].activity<_clauses[b].activity;});
+	vector<bool> removed(_clauses.size(),false);
+	for (size_t i=0;i<learnts.size()/2;++i) {
+		const Clause &c=_clauses[learnts[i]];
+		int v=c.lits[0]>>1;
+		if (_assigns[v]!=0 && _reason[v]==learnts[i]) continue;	// The clause is the reason of an assignment
+		removed[learnts[i]]=true;
+		--_nlearnts;
+	}
+	// Compact the clauses, then update the reasons and the watch lists
+	vector<uint32_t> newindex(_clauses.size(),noreason);
+	size_t k=0;
+	for (size_t i=0;i<_clauses.size();++i) if (!removed[i]) {
+		newindex[i]=k;
+		if (k!=i) _clauses[k]=std::move(_clauses[i]);
+		++k;
+	}
+	_clauses.resize(k);
+	for (uint32_t l:_trail) {
+		uint32_t &r=_reason[l>>1];
+		if (r<binary) r=newindex[r];
+	}
+	for (auto &ws:_watches) {
+		size_t j=0;
+		for (size_t i=0;i<ws.size();++i) {
+			if (ws[i].reason!=binary) {
+				if (removed[ws[i].reason]) continue;
+				ws[i].reason=newindex[ws[i].reason];
+			}
+			ws[j++]=ws[i];
+		}
+		ws.resize(j);
+	}
+}
+
+SatSolver::Result SatSolver::search(size_t maxconflicts) {
+	size_t nconflicts=0;
+	vector<uint32_t> learnt;
+	while (true) {
+		uint32_t conflict=propagate();
+		if (conflict!=noreason) {
+			++_nconflicts;
+			++nconflicts;
+			if (decision_level()==0) {
+				_ok=false;
+				return UNSATISFIABLE;
+			}
+			size_t level=analyze(conflict,learnt);
+			cancel_until(level);
+			if (learnt.size()==1) assign(learnt[0],noreason);
+			else if (learnt.size()==2) {
+				attach_binary(learnt[0],learnt[1]);
+				assign(learnt[0],binary | learnt[1]);
+			} else {
+				_clauses.push_back(Clause{learnt,true,0});
+				bump_clause(_clauses.back());
+				attach(_clauses.size()-1);
+				++_nlearnts;
+				assign(learnt[0],_clauses.size()-1);
+			}
+			_varinc/=0.95;
+			_clainc/=0.999;
+		} else {
+			if (nconflicts>=maxconflicts) {
+				cancel_until(0);
+				return UNKNOWN;
+			}
+			if (_nlearnts>=_maxlearnts+_trail.size()) reduce_learnts();
+			// The assumptions are decided first, a level is opened even if the assumption is already true so that the levels match the assumptions
+			if (decision_level()<_assumptions.size()) {
+				uint32_t p=_assumptions[decision_level()];
+				if (lit_value(p)<0) {
+					cancel_until(0);
+					return UNSATISFIABLE;
+				}
+				_traillim.push_back(_trail.size());
+				if (lit_value(p)==0) assign(p,noreason);
+				continue;
+			}
+			// Choose the unassigned variable with the highest activity
+			int v=-1;
+			while (!_heap.empty() && (v<0 || _assigns[v]!=0)) v=heap_pop();
+			if (v<0 || _assigns[v]!=0) {	// All variables are assigned, this is a model
+				_model=_assigns;
+				cancel_until(0);
+				return SATISFIABLE;
+			}
+			++_ndecisions;
+			_traillim.push_back(_trail.size());
+			assign(2*v+_polarity[v],noreason);
+		}
+	}
+}
+
+SatSolver::Result SatSolver::solve(const std::vector<int> &assumptions,size_t maxconflicts) {
+	if (!_ok) return UNSATISFIABLE;
+	if (propagate()!=noreason) {
+		_ok=false;
+		return UNSATISFIABLE;
+	}
+	_assumptions.clear();
+	for (int l:assumptions) _assumptions.push_back(l>0?2*(l-1):2*(-l-1)+1);
+	_maxlearnts=max(_clauses.size()/3.0,1000.0);
+	size_t start=_nconflicts;
+	for (size_t r=0;;++r) {
+		size_t run=luby(r)*100;
+		if (maxconflicts>0) {
+			if (_nconflicts-start>=maxconflicts) return UNKNOWN;
+			run=min(run,maxconflicts-(_nconflicts-start));
+		}
+		Result res=search(run);
+		if (res!=UNKNOWN) return res;
+		++_nrestarts;
+		_maxlearnts*=1.1;
+	}
+}
+
+void SatSolver::randomize(unsigned seed) {
+	mt19937 generator(seed);
+	uniform_real_distribution<double> dis(0,1e-5);
+	for (size_t v=0;v<_assigns.size();++v) {
+		_activity[v]=dis(generator);
+		_polarity[v]=generator()&1;
+	}
+	_heap.clear();
+	for (auto &h:_heapindex) h=-1;
+	for (size_t v=0;v<_assigns.size();++v) heap_insert(v);
+}
+
+void SatSolver::write_dimacs(ostream &out) const {
+	size_t nunits=0,nbinaries=0,nclauses=0;
+	for (size_t i=0;i<_trail.size() && (_traillim.empty() || i<_traillim[0]);++i) ++nunits;
+	for (uint32_t l=0;l<_watches.size();++l) for (auto &w:_watches[l]) if (w.reason==binary && l<w.blocker) ++nbinaries;
+	for (auto &c:_clauses) if (!c.learnt) ++nclauses;
+	auto dimacs=[](uint32_t l) {return (l&1)?-(int)(l>>1)-1:(int)(l>>1)+1;};
+	out << "p cnf " << _assigns.size() << ' ' << (_ok?nunits+nbinaries+nclauses:1) << '\n';
+	if (!_ok) {
+		out << "0\n";
+		return;
+	}
+	for (size_t i=0;i<nunits;++i) out << dimacs(_trail[i]) << " 0\n";
+	for (uint32_t l=0;l<_watches.size();++l) for (auto &w:_watches[l]) if (w.reason==binary && l<w.blocker) out << dimacs(l) << ' ' << dimacs(w.blocker) << " 0\n";
+	for (auto &c:_clauses) if (!c.learnt) {
+		for (uint32_t l:c.lits) out << dimacs(l) << ' ';
+		out << "0\n";
+	}
+}
+
+void SatSolver::heap_insert(int var) {
+	_heapindex[var]=_heap.size();
+	_heap.push_back(var);
+	heap_up(_heap.size()-1);
+}
+
+int SatSolver::heap_pop() {
+	int v=_heap[0];
+	_heap[0]=_heap.back();
+	_heapindex[_heap[0]]=0;
+	_heapindex[v]=-1;
+	_heap.pop_back();
+	if (_heap.size()>1) heap_down(0);
+	return v;
+}
+
+void SatSolver::heap_up(size_t pos) {
+	int v=_heap[pos];
+	while (pos>0) {
+		size_t parent=(pos-1)>>1;
+		if (_activity[_heap[parent]]>=_activity[v]) break;
+		_heap[pos]=_heap[parent];
+		_heapindex[_heap[pos]]=pos;
+		pos=parent;
+	}
+	_heap[pos]=v;
+	_heapindex[v]=pos;
+}
+
+void SatSolver::heap_down(size_t pos) {
+	int v=_heap[pos];
+	while (2*pos+1<_heap.size()) {
+		size_t child=2*pos+1;
+		if (child+1<_heap.size() && _activity[_heap[child+1]]>_activity[_heap[child]]) ++child;
+		if (_activity[_heap[child]]<=_activity[v]) break;
+		_heap[pos]=_heap[child];
+		_heapindex[_heap[pos]]=pos;
+		pos=child;
+	}
+	_heap[pos]=v;
+	_heapindex[v]=pos;
+}
+
+/**************************************************************************/
+/*                               SatGrid                                  */
+/**************************************************************************/
+
+SatGrid::SatGrid(const Grid &pgrid):_grid(pgrid) {
+	const Geometry &geometry=_grid.geometry();
+	if (geometry.ncages()>0) throw SudokuException(SudokuException::FORMAT_ERROR,"Grids with cages cannot be written as boolean formulas.");
+	size_t d2=_grid.dim2();
+	_variables.assign(d2*d2*d2,0);
+	// Variables and exactly-one constraint of each empty cell
+	for (size_t c=0;c<d2*d2;++c) {
+		Cell *cell=_grid(c/d2,c%d2);
+		if (cell->value!=0) {
+			if (_grid.conflicts(c/d2,c%d2)>0) _solver.add_clause(vector<int>());
+			continue;
+		}
+		vector<int> clause;
+		for (elem_t v=1;v<=d2;++v) if (cell->possible[v-1]) clause.push_back(_variables[c*d2+v-1]=_solver.new_variable());
+		_solver.add_clause(clause);
+		for (size_t i=0;i<clause.size();++i) for (size_t j=i+1;j<clause.size();++j) _solver.add_clause({-clause[i],-clause[j]});
+	}
+	// Exactly-one constraint of each value in each unit
+	for (size_t u=0;u<geometry.nunits();++u) for (elem_t v=1;v<=d2;++v) {
+		if (_grid.get_alternative(u/d2,u%d2,v)==Grid::placed) continue;
+		const size_t *cells=geometry.unit(u);
+		vector<size_t> where;
+		for (size_t i=0;i<d2;++i) if (_variables[cells[i]*d2+v-1]!=0) where.push_back(cells[i]);
+		vector<int> clause;
+		for (size_t c:where) clause.push_back(_variables[c*d2+v-1]);
+		_solver.add_clause(clause);
+		for (size_t i=0;i<where.size();++i) for (size_t j=i+1;j<where.size();++j) {
+			// Two cells may share several units, the binary clause is only added for the first one
+			const size_t *ui=geometry.units(where[i]);
+			const size_t *uj=geometry.units(where[j]);
+			size_t first=u;
+			for (size_t a=0;a<geometry.degree(where[i]);++a) for (size_t b=0;b<geometry.degree(where[j]);++b) if (ui[a]==uj[b] && ui[a]<first) first=ui[a];
+			if (first==u) _solver.add_clause({-clause[i],-clause[j]});
+		}
+	}
+}
+
+size_t SatGrid::solve(Grid::SolveType type,std::function<void(const Grid&)> callback) {
+	size_t maxfound;
+	switch (type) {
+		case Grid::FIND_ONE:
+		case Grid::FIND_ANY:
+			maxfound=1;
+			break;
+		case Grid::FIND_UNIQUE:
+			maxfound=2;
+			break;
+		default:
+			maxfound=numeric_limits<size_t>::max();
+	}
+	if (type==Grid::FIND_ANY) {
+		_solver.randomize(random_seed());
+	}
+	size_t d2=_grid.dim2();
+	size_t nfound=0;
+	while (nfound<maxfound && _solver.solve()==SatSolver::SATISFIABLE) {
+		++nfound;
+		Grid solution(_grid);
+		vector<int> blocking;
+		for (size_t c=0;c<d2*d2;++c) for (elem_t v=1;v<=d2;++v) {
+			int var=_variables[c*d2+v-1];
+			if (var!=0 && _solver.value(var)) {
+				solution.set_value(c/d2,c%d2,v);
+				blocking.push_back(-var);
+			}
+		}
+		if (callback!=0) callback(solution);
+		if (!_solver.add_clause(blocking)) break;
+	}
+	return nfound;
+}
@@ -0,0 +1,284 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sat.h
+ *
+ *    Description:  Definition of the clause-learning solving backend
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 15:10:22
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SAT_INC
+#define  SAT_INC
+
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+#include "objects.h"
+
+/**
+ * \brief Conflict-driven clause-learning solver
+ *
+ * The class solves boolean formulas in conjunctive normal form. It does not depend on any external library. The search uses unit propagation with two watched literals, learns a clause from each conflict by the first unique implication point, backjumps non-chronologically to the level where the learnt clause becomes unit, chooses the branching variables by decaying activity (VSIDS) with saved phases, and restarts following the Luby sequence. Learnt clauses are periodically reduced by activity.
+ * Variables and literals follow the DIMACS convention: variables are numbered from 1, and the literal -v is the negation of the variable v. Binary clauses, which are most of the clauses of a Sudoku grid, are only stored in the watch lists.
+ * Clauses can be added between two calls to SatSolver::solve, so that the solver can be used incrementally, for example to block the solutions already found.
+ */
+class SatSolver {
+	public:
+		/**
+		 * \brief Result of a search
+		 */
+		enum Result {
+			SATISFIABLE,	//!< A model has been found, see SatSolver::value
+			UNSATISFIABLE,	//!< The formula has no model
+			UNKNOWN	//!< The search stopped before reaching a conclusion
+		};
+
+		SatSolver();	//!< Standard constructor, creating an empty formula
+
+		/**
+		 * \brief Create a new variable
+		 *
+		 * \return Number of the new variable, starting with 1
+		 */
+		int new_variable();
+
+		/**
+		 * \brief Number of variables
+		 *
+		 * \return Number of variables of the formula
+		 */
+		size_t nvariables() const {return _assigns.size();}
+
+		/**
+		 * \brief Add a clause to the formula
+		 *
+		 * The clause is simplified with the values already known at the root of the search. An empty clause makes the formula unsatisfiable.
+		 * \param clause Literals of the clause
+		 * \return False if the formula is now known to be unsatisfiable, true otherwise
+		 */
+		bool add_clause(const std::vector<int> &clause);
+
+		/**
+		 * \brief Look for a model of the formula
+		 *
+		 * \param maxconflicts Number of conflicts after which the search stops with SatSolver::UNKNOWN, 0 for no limit
+		 * \return Result of the search
+		 */
+		Result solve(size_t maxconflicts=0) {return solve(std::vector<int>(),maxconflicts);}
+
+		/**
+		 * \brief Look for a model of the formula under assumptions
+		 *
+		 * The assumptions are literals which are taken as the first decisions of the search, each one at its own decision level. The formula is not changed, so that the clauses learnt under some assumptions stay valid for the next calls with other assumptions. This is how a series of related questions on the same formula is answered incrementally.
+		 * \param assumptions Literals assumed true
+		 * \param maxconflicts Number of conflicts after which the search stops with SatSolver::UNKNOWN, 0 for no limit
+		 * \return Result of the search, SatSolver::UNSATISFIABLE if the formula has no model where the assumptions are true
+		 */
+		Result solve(const std::vector<int> &assumptions,size_t maxconflicts=0);
+
+		/**
+		 * \brief Value of a variable in the last model found
+		 *
+		 * \param variable Number of the variable
+		 * \return Value of the variable
+		 */
+		bool value(int variable) const {return _model[variable-1]>0;}
+
+		/**
+		 * \brief Randomize the search
+		 *
+		 * This method gives random initial activities and phases to the variables, so that two solvers with different seeds explore the search space in a different order and may find different models.
+		 * \param seed Seed of the random generator
+		 */
+		void randomize(unsigned seed);
+
+		/**
+		 * \brief Write the formula in DIMACS format
+		 *
+		 * The method writes the clauses of the formula, together with the values known at the root of the search as unit clauses. Learnt clauses of more than two literals are not written.
+		 * \param out Output stream
+		 */
+		void write_dimacs(std::ostream &out) const;
+
+		size_t nconflicts() const {return _nconflicts;}	//!< Number of conflicts since the creation of the solver
+		size_t ndecisions() const {return _ndecisions;}	//!< Number of decisions since the creation of the solver
+		size_t npropagations() const {return _npropagations;}	//!< Number of propagated literals since the creation of the solver
+		size_t nrestarts() const {return _nrestarts;}	//!< Number of restarts since the creation of the solver
+
+	private:
+		/**
+		 * \brief Clause of more than two literals
+		 *
+		 * The two first literals of the clause are the watched ones. When the clause is the reason of an assignment, the assigned literal is the first one.
+		 */
+		struct Clause {
+			std::vector<uint32_t> lits;	//!< Literals of the clause, in the internal numbering
+			bool learnt;	//!< Tell if the clause has been learnt during the search
+			double activity;	//!< Activity of a learnt clause, bumped when it takes part in a conflict
+		};
+
+		/**
+		 * \brief Entry of a watch list
+		 *
+		 * A watcher refers either to a clause, or to a binary clause whose other literal is stored in the blocker.
+		 */
+		struct Watcher {
+			uint32_t reason;	//!< Index of the clause, or SatSolver::binary with the other literal of a binary clause
+			uint32_t blocker;	//!< Literal of the clause, the clause is satisfied and need not be visited when it is true
+		};
+
+		static const uint32_t binary=0x80000000u;	//!< Flag of the reasons made of a binary clause, the other literal is in the low bits
+		static const uint32_t noreason=0xffffffffu;	//!< Reason of decisions and of the values known at the root
+		static const uint32_t binaryconflict=0xfffffffeu;	//!< Conflict on a binary clause, whose literals are in SatSolver::_conflict
+
+		bool _ok;	//!< False when the formula is known to be unsatisfiable
+		std::vector<Clause> _clauses;	//!< Clauses of more than two literals, original and learnt
+		std::vector<std::vector<Watcher> > _watches;	//!< Watch list of each literal, visited when the literal becomes false
+		std::vector<signed char> _assigns;	//!< Current value of each variable, 1 for true, -1 for false, 0 if unassigned
+		std::vector<signed char> _model;	//!< Values of the variables in the last model found
+		std::vector<signed char> _polarity;	//!< Saved phase of each variable, used for the next decision on it
+		std::vector<size_t> _level;	//!< Decision level of each assigned variable
+		std::vector<uint32_t> _reason;	//!< Reason of each assigned variable
+		std::vector<uint32_t> _trail;	//!< Assigned literals in chronological order
+		std::vector<size_t> _traillim;	//!< Position in the trail of the decision of each level
+		std::vector<uint32_t> _assumptions;	//!< Literals assumed true by the current search, decided at the first levels
+		size_t _qhead;	//!< Position in the trail of the next literal to propagate
+		std::vector<double> _activity;	//!< Activity of each variable
+		double _varinc;	//!< Amount added to the activity of a variable when it is bumped
+		double _clainc;	//!< Amount added to the activity of a clause when it is bumped
+		std::vector<int> _heap;	//!< Binary heap of the candidate variables for decisions, ordered by activity
+		std::vector<int> _heapindex;	//!< Position of each variable in the heap, -1 if it is not there
+		std::vector<char> _seen;	//!< Marks used during conflict analysis
+		size_t _nlearnts;	//!< Number of learnt clauses in SatSolver::_clauses
+		double _maxlearnts;	//!< Number of learnt clauses above which the learnt clauses are reduced
+		uint32_t _conflict[2];	//!< Literals of the last conflicting binary clause
+		size_t _nconflicts;	//!< Number of conflicts
+		size_t _ndecisions;	//!< Number of decisions
+		size_t _npropagations;	//!< Number of propagated literals
+		size_t _nrestarts;	//!< Number of restarts
+
+		signed char lit_value(uint32_t lit) const {return (lit&1)?-_assigns[lit>>1]:_assigns[lit>>1];}	//!< Value of a literal, 1 for true, -1 for false, 0 if unassigned
+		size_t decision_level() const {return _traillim.size();}	//!< Current decision level
+		void assign(uint32_t lit,uint32_t reason);	//!< Make a literal true
+		void attach(uint32_t index);	//!< Add a clause to the watch lists of its two first literals
+		void attach_binary(uint32_t a,uint32_t b);	//!< Add a binary clause to the watch lists
+
+		/**
+		 * \brief Propagate the assigned literals
+		 *
+		 * \return SatSolver::noreason if there is no conflict, otherwise the index of the conflicting clause, or SatSolver::binaryconflict for a binary clause
+		 */
+		uint32_t propagate();
+
+		/**
+		 * \brief Literals of a reason or of a conflict
+		 *
+		 * \param reason Reason or conflict, as returned by SatSolver::propagate
+		 * \param lit Literal implied by the reason, ignored for a conflict
+		 * \param tmp Array used to store the literals of a binary clause
+		 * \param n Number of literals of the clause
+		 * \return Pointer to the literals of the clause, the implied literal being the first one
+		 */
+		const uint32_t *reason_lits(uint32_t reason,uint32_t lit,uint32_t *tmp,size_t &n) const;
+
+		/**
+		 * \brief Learn a clause from a conflict
+		 *
+		 * \param conflict Conflict returned by SatSolver::propagate
+		 * \param learnt Learnt clause, the asserting literal being the first one and a literal of the backjump level the second one
+		 * \return Level to backjump to
+		 */
+		size_t analyze(uint32_t conflict,std::vector<uint32_t> &learnt);
+
+		void cancel_until(size_t level);	//!< Undo the assignments above a decision level
+		void bump_variable(int var);	//!< Increase the activity of a variable
+		void bump_clause(Clause &clause);	//!< Increase the activity of a learnt clause
+		void reduce_learnts();	//!< Remove the half of the learnt clauses with the lowest activity
+
+		/**
+		 * \brief Search for a model until a number of conflicts
+		 *
+		 * \param maxconflicts Number of conflicts after which the search is restarted
+		 * \return Result of the search, SatSolver::UNKNOWN if it must be restarted
+		 */
+		Result search(size_t maxconflicts);
+
+		void heap_insert(int var);	//!< Insert a variable in the decision heap
+		int heap_pop();	//!< Remove the variable with the highest activity from the decision heap
+		void heap_up(size_t pos);	//!< Move up an element of the heap
+		void heap_down(size_t pos);	//!< Move down an element of the heap
+};
+
+/**
+ * \brief Sudoku grid encoded as a boolean formula
+ *
+ * The class encodes a grid for SatSolver, with one variable for each value still possible in each empty cell. Each empty cell holds exactly one value, and each value not yet placed appears exactly once in each unit of the geometry. The exactly-one constraints are made of a clause for the at-least-one part and of binary clauses for the at-most-one part.
+ * It is an alternative backend to Grid::solve for large grids, where the solving time of the backtracking algorithm is very irregular.
+ */
+class SatGrid {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor builds the formula of the grid.
+		 * \param pgrid Grid to solve, it is copied
+		 */
+		SatGrid(const Grid &pgrid);
+
+		/**
+		 * \brief Solve the grid
+		 *
+		 * This method works as Grid::solve, with the same types of solving. Each solution found is blocked by a clause forbidding it, which is how the uniqueness is checked with Grid::FIND_UNIQUE and how all solutions are listed with Grid::FIND_ALL. As the blocking clauses are kept, another call goes on with the solutions not found yet.
+		 * \param type Tells if the algorithm must find one solution, any solution, a unique solution or all solutions
+		 * \param callback Callback function applied on each solution grid
+		 * \return Number of solutions found
+		 */
+		size_t solve(Grid::SolveType type=Grid::FIND_ONE,std::function<void(const Grid&)> callback=&Grid::write_to_cout);
+
+		/**
+		 * \brief Write the formula of the grid in DIMACS format
+		 *
+		 * \param out Output stream
+		 */
+		void write_dimacs(std::ostream &out) const {_solver.write_dimacs(out);}
+
+		/**
+		 * \brief Accessor to the underlying solver
+		 *
+		 * \return Solver of the formula, which gives the statistics of the search
+		 */
+		const SatSolver& solver() const {return _solver;}
+
+		/**
+		 * \brief Accessor to the underlying solver
+		 *
+		 * \return Solver of the formula, which can be given assumptions or new clauses on the variables of the grid
+		 */
+		SatSolver& solver() {return _solver;}
+
+		/**
+		 * \brief Variable of a value of a cell
+		 *
+		 * \param cell Index of the cell, see Geometry
+		 * \param value Value of the cell
+		 * \return Number of the variable telling if the cell holds the value, 0 if the value is not possible in the cell or if the cell is already filled
+		 */
+		int variable(size_t cell,elem_t value) const {return _variables[cell*_grid.dim2()+value-1];}
+
+	private:
+		Grid _grid;	//!< Grid to solve
+		SatSolver _solver;	//!< Solver of the formula
+		std::vector<int> _variables;	//!< Variable of each value of each cell, at index cell*dim2+value-1, 0 if the value is not possible
+};
+
+#endif   /* ----- #ifndef SAT_INC  ----- */
@@ -0,0 +1,76 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  session.cpp
+ *
+ *    Description:  Implementation of the solving sessions keeping their state between calls
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 21:37:20
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include "session.h"
+#include "geometry.h"
+
+using namespace std;
+
+void SolverSession::reset(const Grid &pgrid) {
+	_grid=pgrid;
+	_solution=Grid();
+	_valid=false;
+	_changed.clear();
+}
+
+void SolverSession::assign(size_t row,size_t column,elem_t value) {
+	elem_t old=_grid(row,column)->value;
+	if (old==value) return;
+	if (old!=0) _grid.unset_value(row,column);
+	if (value==0) return;	// Erasing a value keeps the last solution valid
+	_grid.set_value(row,column,value);
+	if (_valid && _solution(row,column)->value!=value) _valid=false;
+	_changed.push_back(row*_grid.dim2()+column);
+}
+
+bool SolverSession::solve(Grid &solution) {
+	size_t d2=_grid.dim2();
+	if (_valid) {
+		++_nreused;
+		solution=_solution;
+		return true;
+	}
+	for (size_t i=0;i<d2;++i) for (size_t j=0;j<d2;++j) if (_grid.conflicts(i,j)>0) return false;
+	Grid found;
+	auto keep=[&found](const Grid &g) {found=g;};
+	if (_solution.dim2()!=0) {
+		// Keep the last solution far from the changed cells and solve the rest
+		const Geometry &geometry=_grid.geometry();
+		vector<bool> freed(d2*d2,false);
+		for (size_t c:_changed) {
+			freed[c]=true;
+			for (size_t p=0;p<geometry.npeers(c);++p) freed[geometry.peers(c)[p]]=true;
+		}
+		Grid trial(_grid);
+		for (size_t c=0;c<d2*d2;++c) {
+			Cell *cell=trial(c/d2,c%d2);
+			elem_t v=_solution(c/d2,c%d2)->value;
+			if (!freed[c] && cell->value==0 && cell->possible[v-1]) trial.set_value(c/d2,c%d2,v);
+		}
+		if (trial.solve(Grid::FIND_ONE,keep)>0) ++_nrepaired;
+	}
+	if (found.dim2()==0) {
+		if (_grid.solve_portfolio(keep)==0) return false;	// The last solution is kept to repair it after the next changes
+		++_nsearched;
+	}
+	_solution=std::move(found);
+	_valid=true;
+	_changed.clear();
+	solution=_solution;
+	return true;
+}
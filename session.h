@@ -0,0 +1,97 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  session.h
+ *
+ *    Description:  Definition of the solving sessions keeping their state between calls
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 21:15:44
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SESSION_INC
+#define  SESSION_INC
+
+#include <vector>
+#include "objects.h"
+
+/**
+ * \brief Solving session of a grid edited step by step
+ *
+ * The class keeps a grid and its last solution between the calls, for the callers which solve the same grid again after each small change, like the interactive interface. The values are set and erased with SolverSession::assign and SolverSession::unassign, which update the propagated state of the grid incrementally through Grid::set_value and Grid::unset_value instead of reading the clues again.
+ * SolverSession::solve returns the last solution immediately when it is still consistent with the grid: erasing a value never invalidates it, and setting a value only does if the solution holds another value in the cell. Otherwise, the last solution is used as a starting point: its values are kept in the cells which are not peers of a changed cell, and only the neighbourhood of the changes is solved again. The full search from the retained state, with Grid::solve_portfolio, is only run if this repair fails.
+ */
+class SolverSession {
+	public:
+		SolverSession():_valid(false),_nreused(0),_nrepaired(0),_nsearched(0) {}	//!< Standard constructor, creating a session without grid
+
+		/**
+		 * \brief Constructor from a grid
+		 *
+		 * \param pgrid Grid to solve, it is copied
+		 */
+		explicit SolverSession(const Grid &pgrid):SolverSession() {reset(pgrid);}
+
+		/**
+		 * \brief Replace the grid of the session
+		 *
+		 * The last solution is forgotten.
+		 * \param pgrid New grid, it is copied
+		 */
+		void reset(const Grid &pgrid);
+
+		/**
+		 * \brief Set the value of a cell
+		 *
+		 * If the cell already holds a value, it is erased first.
+		 * \param row Row index of the cell
+		 * \param column Column index of the cell
+		 * \param value New value of the cell, 0 to erase it
+		 */
+		void assign(size_t row,size_t column,elem_t value);
+
+		/**
+		 * \brief Erase the value of a cell
+		 *
+		 * \param row Row index of the cell
+		 * \param column Column index of the cell
+		 */
+		void unassign(size_t row,size_t column) {assign(row,column,0);}
+
+		/**
+		 * \brief Solve the grid
+		 *
+		 * \param solution Grid receiving a solution of the grid, if one is found
+		 * \return True if a solution has been found, false if the grid has none
+		 */
+		bool solve(Grid &solution);
+
+		/**
+		 * \brief Accessor to the grid of the session
+		 *
+		 * \return Current grid
+		 */
+		const Grid& grid() const {return _grid;}
+
+		size_t nreused() const {return _nreused;}	//!< Number of calls which returned the last solution
+		size_t nrepaired() const {return _nrepaired;}	//!< Number of calls solved by repairing the last solution
+		size_t nsearched() const {return _nsearched;}	//!< Number of calls which needed a full search
+
+	private:
+		Grid _grid;	//!< Current grid
+		Grid _solution;	//!< Last solution found, empty grid if there is none
+		bool _valid;	//!< Tell if the last solution is consistent with the current grid
+		std::vector<size_t> _changed;	//!< Cells whose value has been set since the last solution was found
+		size_t _nreused;	//!< Number of calls which returned the last solution
+		size_t _nrepaired;	//!< Number of calls solved by repairing the last solution
+		size_t _nsearched;	//!< Number of calls which needed a full search
+};
+
+#endif   /* ----- #ifndef SESSION_INC  ----- */
@@ -0,0 +1,229 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sinks.cpp
+ *
+ *    Description:  Implementation of the output sinks for the enumeration of solutions
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 11:41:03
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include "sinks.h"
+
+using namespace std;
+
+static const char solutions_magic[8]={'S','U','D','O','K','U','S','L'};	//!< Magic string at the beginning of a binary stream of solutions
+
+/**************************************************************************/
+/*                              AsyncWriter                               */
+/**************************************************************************/
+
+AsyncWriter::AsyncWriter(int pfd,size_t pbuffersize,size_t pnbuffers):_fd(pfd),_current(pbuffersize),_used(0),_buffersize(pbuffersize),_done(false),_busy(false),_error(0) {
+	for (size_t i=1;i<pnbuffers;++i) _free.push_back(vector<char>(pbuffersize));
+	_thread=thread(&AsyncWriter::run,this);
+}
+
+AsyncWriter::~AsyncWriter() {
+	try {
+		submit();
+	} catch (...) {}
+	{
+		unique_lock<mutex> lock(_mutex);
+		_done=true;
+	}
+	_cvfull.notify_one();
+	_thread.join();
+}
+
+void AsyncWriter::write(const char *data,size_t n) {
+	while (n>0) {
+		size_t k=_current.size()-_used;
+		if (k==0) {
+			submit();
+			k=_current.size();
+		}
+		if (k>n) k=n;
+		memcpy(&_current[_used],data,k);
+		_used+=k;
+		data+=k;
+		n-=k;
+	}
+}
+
+void AsyncWriter::submit() {
+	if (_used==0) return;
+	unique_lock<mutex> lock(_mutex);
+	_current.resize(_used);
+	_full.push_back(std::move(_current));
+	_cvfull.notify_one();
+	_cvfree.wait(lock,[this] {return !_free.empty();});
+	_current=std::move(_free.back());
+	_free.pop_back();
+	_current.resize(_buffersize);
+	_used=0;
+}
+
+void AsyncWriter::flush() {
+	submit();
+	unique_lock<mutex> lock(_mutex);
+	_cvfree.wait(lock,[this] {return _full.empty() && !_busy;});
+	if (_error!=0) throw SudokuException(SudokuException::IO_ERROR,string("Unable to write the solutions: ")+strerror(_error));
+}
+
+void AsyncWriter::run() {
+	unique_lock<mutex> lock(_mutex);
+	while (true) {
+		_cvfull.wait(lock,[this] {return _done || !_full.empty();});
+		if (_full.empty()) return;
+		vector<char> buffer=std::move(_full.front());
+		_full.pop_front();
+		_busy=true;
+		lock.unlock();
+		size_t k=0;
+		while (k<buffer.size() && _error==0) {
+			ssize_t res=::write(_fd,&buffer[k],buffer.size()-k);
+			if (res<0) {
+				if (errno!=EINTR) _error=errno;
+			} else k+=res;
+		}
+		lock.lock();
+		_busy=false;
+		_free.push_back(std::move(buffer));
+		_cvfree.notify_all();
+	}
+}
+
+/**************************************************************************/
+/*                                Sinks                                   */
+/**************************************************************************/
+
+void TextSink::put(const Grid &grid) {
+	size_t d2=grid.dim2();
+	for (size_t i=0;i<d2;++i) {
+		char *p=_writer.reserve(d2*4);
+		char *q=p;
+		for (size_t j=0;j<d2;++j) {
+			elem_t v=grid(i,j)->value;
+			if (j>0) *(q++)='\t';
+			if (v>=10) {
+				*(q++)='0'+v/10;
+				v%=10;
+			}
+			*(q++)='0'+v;
+		}
+		*(q++)='\n';
+		_writer.commit(q-p);
+	}
+	*_writer.reserve(1)='\n';
+	_writer.commit(1);
+}
+
+void BinarySink::write_header(size_t dim2,unsigned char format) {
+	_dim2=dim2;
+	_writer.write(solutions_magic,sizeof(solutions_magic));
+	char h[2]={(char)dim2,(char)format};
+	_writer.write(h,2);
+}
+
+void BinarySink::write_full(const Grid &grid) {
+	size_t n=grid.dim2()*grid.dim2();
+	if (grid.dim2()<16) {
+		unsigned char *p=(unsigned char*)_writer.reserve((n+1)/2);
+		for (size_t i=0;i<n;i+=2) p[i/2]=(unsigned char)(grid(i/grid.dim2(),i%grid.dim2())->value | ((i+1<n)?(grid((i+1)/grid.dim2(),(i+1)%grid.dim2())->value<<4):0));
+		_writer.commit((n+1)/2);
+	} else {
+		grid.write_packed((unsigned char*)_writer.reserve(n));
+		_writer.commit(n);
+	}
+}
+
+void BinarySink::put(const Grid &grid) {
+	if (_dim2==0) write_header(grid.dim2(),0);
+	write_full(grid);
+}
+
+void BinarySink::resume(const std::vector<unsigned char> &previous) {
+	size_t d2=0;
+	while (d2*d2<previous.size()) ++d2;
+	_dim2=d2;	// The header has been written with the first solution
+}
+
+void DeltaSink::resume(const std::vector<unsigned char> &previous) {
+	BinarySink::resume(previous);
+	_previous=previous;
+	_values.resize(previous.size());
+}
+
+void DeltaSink::put(const Grid &grid) {
+	size_t n=grid.dim2()*grid.dim2();
+	if (_dim2==0) {
+		write_header(grid.dim2(),1);
+		write_full(grid);
+		_previous.resize(n);
+		_values.resize(n);
+		grid.write_packed(&_previous[0]);
+		return;
+	}
+	grid.write_packed(&_values[0]);
+	unsigned char *p=(unsigned char*)_writer.reserve(2+3*n);
+	size_t k=0;
+	for (size_t i=0;i<n;++i) if (_values[i]!=_previous[i]) {
+		p[2+3*k]=(unsigned char)(i & 0xff);
+		p[3+3*k]=(unsigned char)(i>>8);
+		p[4+3*k]=_values[i];
+		++k;
+	}
+	p[0]=(unsigned char)(k & 0xff);
+	p[1]=(unsigned char)(k>>8);
+	_writer.commit(2+3*k);
+	_previous.swap(_values);
+}
+
+/**************************************************************************/
+/*                            SolutionReader                              */
+/**************************************************************************/
+
+SolutionReader::SolutionReader(std::istream &pin):_in(pin),_first(true) {
+	char h[sizeof(solutions_magic)+2];
+	if (!_in.read(h,sizeof(h)) || memcmp(h,solutions_magic,sizeof(solutions_magic))!=0 || h[sizeof(solutions_magic)+1]>1) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid stream of solutions.");
+	_dim2=(unsigned char)h[sizeof(solutions_magic)];
+	_format=h[sizeof(solutions_magic)+1];
+	_values.resize(_dim2*_dim2);
+}
+
+bool SolutionReader::next(std::vector<unsigned char> &values) {
+	size_t d2=_dim2;
+	size_t n=d2*d2;
+	if (_format==0 || _first) {
+		if (d2<16) {
+			vector<char> buf((n+1)/2);
+			if (!_in.read(&buf[0],buf.size())) return false;
+			for (size_t i=0;i<n;++i) _values[i]=((unsigned char)buf[i/2]>>((i%2)*4)) & 0xf;
+		} else if (!_in.read((char*)&_values[0],n)) return false;
+		_first=false;
+	} else {
+		unsigned char h[2];
+		if (!_in.read((char*)h,2)) return false;
+		size_t k=h[0] | (h[1]<<8);
+		vector<unsigned char> buf(3*k);
+		if (k>0 && !_in.read((char*)&buf[0],buf.size())) throw SudokuException(SudokuException::FORMAT_ERROR,"Truncated stream of solutions.");
+		for (size_t i=0;i<k;++i) {
+			size_t ind=buf[3*i] | (buf[3*i+1]<<8);
+			if (ind>=n) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid stream of solutions.");
+			_values[ind]=buf[3*i+2];
+		}
+	}
+	values=_values;
+	return true;
+}
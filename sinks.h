@@ -0,0 +1,302 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sinks.h
+ *
+ *    Description:  Definition of the output sinks for the enumeration of solutions
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 11:05:27
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SINKS_INC
+#define  SINKS_INC
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <istream>
+#include "objects.h"
+
+/**
+ * \brief Asynchronous writer with bounded buffers
+ *
+ * The class writes data to a file descriptor from a dedicated thread. The producer fills a buffer in memory and hands it to the writer thread when it is full, then goes on with a free buffer. The number of buffers is fixed, so the producer can run ahead of the disk by at most this number of buffers and then waits for the writer thread, which bounds the memory used.
+ */
+class AsyncWriter {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The standard constructor allocates the buffers and starts the writer thread.
+		 * \param pfd File descriptor where the data is written, it is not closed by the object
+		 * \param pbuffersize Size of each buffer in bytes
+		 * \param pnbuffers Number of buffers, at least 2
+		 */
+		AsyncWriter(int pfd,size_t pbuffersize=1<<20,size_t pnbuffers=4);
+
+		/**
+		 * \brief Standard destructor
+		 *
+		 * The standard destructor writes the pending data and stops the writer thread. Errors are ignored, call AsyncWriter::flush before to catch them.
+		 */
+		~AsyncWriter();
+
+		AsyncWriter(const AsyncWriter&)=delete;
+		AsyncWriter& operator=(const AsyncWriter&)=delete;
+
+		/**
+		 * \brief Reserve space in the current buffer
+		 *
+		 * This method returns a pointer where at least n bytes can be written. The data is only taken into account after a call to AsyncWriter::commit. If the current buffer has not enough space left, it is handed to the writer thread first.
+		 * \param n Number of bytes needed, it must not be greater than the size of a buffer
+		 * \return Pointer to the free space of the current buffer
+		 */
+		char *reserve(size_t n) {
+			if (_used+n>_current.size()) submit();
+			return &_current[_used];
+		}
+
+		/**
+		 * \brief Commit data written in the current buffer
+		 *
+		 * \param n Number of bytes written at the address returned by AsyncWriter::reserve
+		 */
+		void commit(size_t n) {_used+=n;}
+
+		/**
+		 * \brief Write data
+		 *
+		 * This method copies data in the buffers, it may be larger than a buffer.
+		 * \param data Pointer to the data
+		 * \param n Number of bytes to write
+		 */
+		void write(const char *data,size_t n);
+
+		/**
+		 * \brief Write all pending data
+		 *
+		 * This method hands the current buffer to the writer thread and waits until all the buffers have been written. It throws a SudokuException if an error happened while writing.
+		 */
+		void flush();
+
+	private:
+		int _fd;	//!< File descriptor where data is written
+		std::vector<char> _current;	//!< Buffer being filled by the producer
+		size_t _used;	//!< Number of bytes used in the current buffer
+		std::deque<std::vector<char> > _full;	//!< Buffers waiting to be written, with their size set to the number of bytes to write
+		std::vector<std::vector<char> > _free;	//!< Buffers available to the producer
+		size_t _buffersize;	//!< Size of each buffer
+		bool _done;	//!< Tell the writer thread to stop when all buffers are written
+		bool _busy;	//!< Tell if the writer thread is writing a buffer
+		int _error;	//!< Error number of the first failed write, 0 if there was no error
+		std::mutex _mutex;	//!< Mutex protecting the queues
+		std::condition_variable _cvfull;	//!< Signaled when a buffer is ready to be written or when the writer must stop
+		std::condition_variable _cvfree;	//!< Signaled when a buffer has been written
+		std::thread _thread;	//!< Writer thread
+
+		/**
+		 * \brief Hand the current buffer to the writer thread
+		 *
+		 * The method queues the current buffer and takes a free buffer, waiting for one if all the buffers are in use.
+		 */
+		void submit();
+
+		/**
+		 * \brief Main loop of the writer thread
+		 */
+		void run();
+};
+
+/**
+ * \brief Generic sink for the solutions of a grid
+ *
+ * A sink receives the solutions found by Grid::solve and writes them somewhere. It can be used directly as a callback function, for example grid.solve(Grid::FIND_ALL,std::ref(sink)).
+ */
+class SolutionSink {
+	public:
+		SolutionSink():count(0) {}	//!< Standard constructor
+		virtual ~SolutionSink() {}	//!< Standard destructor
+
+		/**
+		 * \brief Receive a solution
+		 *
+		 * \param grid Solution grid
+		 */
+		void operator()(const Grid &grid) {
+			put(grid);
+			++count;
+		}
+
+		/**
+		 * \brief Write all pending data
+		 *
+		 * This method must be called when the enumeration is over. It throws a SudokuException if the data could not be written.
+		 */
+		virtual void finish()=0;
+
+		/**
+		 * \brief Go on with an interrupted output
+		 *
+		 * This method must be called before the first solution when the sink appends solutions to the output of an interrupted enumeration, so that the new solutions continue the stream.
+		 * \param previous Last solution written in the output, in the packed format of Grid::write_packed, or empty vector if none has been written
+		 */
+		virtual void resume(const std::vector<unsigned char> &previous) {}
+
+		size_t count;	//!< Number of solutions received
+
+	protected:
+		/**
+		 * \brief Write a solution
+		 *
+		 * \param grid Solution grid
+		 */
+		virtual void put(const Grid &grid)=0;
+};
+
+/**
+ * \brief Sink only counting the solutions
+ */
+class CountSink:public SolutionSink {
+	public:
+		void finish() {}
+
+	protected:
+		void put(const Grid &grid) {}
+};
+
+/**
+ * \brief Sink writing solutions as text
+ *
+ * The sink writes the solutions in the same format as Grid::write_to_cout, with values separated by tabulations and an empty line after each grid. Values are formatted directly in the buffers of an AsyncWriter instead of going through the streams.
+ */
+class TextSink:public SolutionSink {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param pfd File descriptor where the solutions are written
+		 */
+		TextSink(int pfd):_writer(pfd) {}
+		void finish() {_writer.flush();}
+
+	protected:
+		void put(const Grid &grid);
+
+	private:
+		AsyncWriter _writer;	//!< Writer of the text
+};
+
+/**
+ * \brief Sink writing solutions in packed binary form
+ *
+ * The stream starts with a header made of the magic string "SUDOKUSL", the number of rows of the grid and the format (0 for this sink). Then each solution is written with one value per cell, row by row. Values are packed by two in a byte (low nibble first) if they are lower than 16, and take one byte each otherwise.
+ * The stream can be read back with SolutionReader.
+ */
+class BinarySink:public SolutionSink {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param pfd File descriptor where the solutions are written
+		 */
+		BinarySink(int pfd):_writer(pfd),_dim2(0) {}
+		void finish() {_writer.flush();}
+		void resume(const std::vector<unsigned char> &previous);
+
+		static const size_t header_size=10;	//!< Size of the header of the stream in bytes
+
+	protected:
+		void put(const Grid &grid);
+		AsyncWriter _writer;	//!< Writer of the data
+		size_t _dim2;	//!< Number of rows of the grids, 0 before the header is written
+
+		/**
+		 * \brief Write the header of the stream
+		 *
+		 * \param dim2 Number of rows of the grids
+		 * \param format Format of the stream, 0 for packed and 1 for delta-encoded
+		 */
+		void write_header(size_t dim2,unsigned char format);
+
+		/**
+		 * \brief Write a full packed grid
+		 *
+		 * \param grid Grid to write
+		 */
+		void write_full(const Grid &grid);
+};
+
+/**
+ * \brief Sink writing solutions with delta encoding
+ *
+ * The stream starts with the same header as BinarySink, with format 1, followed by the first solution in packed form. Each following solution is written as the number of cells which differ from the previous solution on two bytes (little endian), then for each of these cells its index on two bytes and its new value on one byte.
+ * Solutions enumerated by Grid::solve come in depth-first order, so consecutive solutions share most of their values and the stream is much smaller than the packed one.
+ */
+class DeltaSink:public BinarySink {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param pfd File descriptor where the solutions are written
+		 */
+		DeltaSink(int pfd):BinarySink(pfd) {}
+		void resume(const std::vector<unsigned char> &previous);
+
+	protected:
+		void put(const Grid &grid);
+
+	private:
+		std::vector<unsigned char> _previous;	//!< Values of the previous solution
+		std::vector<unsigned char> _values;	//!< Values of the current solution
+};
+
+/**
+ * \brief Reader of binary streams of solutions
+ *
+ * The class reads the streams written by BinarySink and DeltaSink and gives back the solutions one by one, in the packed form of Grid::write_packed.
+ */
+class SolutionReader {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor reads the header of the stream. It throws a SudokuException if the header is not valid.
+		 * \param pin Input stream, opened in binary mode
+		 */
+		SolutionReader(std::istream &pin);
+
+		/**
+		 * \brief Read the next solution
+		 *
+		 * \param values Vector receiving the values of the solution, one per cell row by row
+		 * \return True if a solution has been read, false at the end of the stream
+		 */
+		bool next(std::vector<unsigned char> &values);
+
+		/**
+		 * \brief Accessor to the number of rows of the grids of the stream
+		 *
+		 * \return Number of rows (or columns) of the grids
+		 */
+		size_t dim2() const {return _dim2;}
+
+	private:
+		std::istream &_in;	//!< Input stream
+		size_t _dim2;	//!< Number of rows of the grids
+		unsigned char _format;	//!< Format of the stream, 0 for packed and 1 for delta-encoded
+		bool _first;	//!< Tell if no solution has been read yet
+		std::vector<unsigned char> _values;	//!< Values of the last solution read
+};
+
+#endif   /* ----- #ifndef SINKS_INC  ----- */
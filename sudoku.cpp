@@ -18,41 +18,1054 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
 #include "objects.h"
+#include "bank.h"
+#include "sinks.h"
+#include "sat.h"
+#include "batch.h"
+#include "count.h"
+#include "verify.h"
+#include "checkpoint.h"
+#include "workqueue.h"
+#include "driver.h"
+#include "backbone.h"
+#include "symmetry.h"
+#include "trace.h"
 #include "gui_curses.h"
 
 using namespace std;
 
 /**
- * \brief Main program
+ * \brief Request for refilling the puzzle bank
+ */
+struct RefillRequest {
+	size_t dimension;	//!< Dimension of the grids to generate
+	size_t difficulty;	//!< Level of difficulty of the grids to generate
+	size_t count;	//!< Number of grids to generate
+};
+
+/**
+ * \brief Request for generating puzzles in a band of difficulty
+ */
+struct RatedRequest {
+	size_t dimension;	//!< Dimension of the grids to generate
+	size_t minscore;	//!< Lowest score of the grids, see Grid::Rating
+	size_t maxscore;	//!< Highest score of the grids
+	size_t count;	//!< Number of grids to generate
+};
+
+/**
+ * \brief Print the usage of the program
  *
- * The main program starts the game and the main execution loop.
- * \param argc Number of arguments in command line, including the name of the program
- * \param argv Array of arguments in command line, the first one being the name of the program
+ * \param name Name of the program
  */
-int main(int argc,char **argv) {
-/* 	Grid *grid;
- * 	if (argc>1) {
- * 		ifstream ifs(argv[1]);
- * 		grid=new Grid(ifs);
- * 	} else grid=new Grid(cin);
- * 	grid->solve(Grid::FIND_ALL);
+void usage(const char *name) {
+	cerr << "Usage: " << name << " [-b bank] [-r dimension:difficulty:count]... [-l]\n";
+	cerr << "       " << name << " -s|-e text|binary|delta|count|classes|-d dimacs [-a algorithm] [-o output] [-k checkpoint [-i seconds]] [-x] [-j regions] [-K cages] [-t trace] [grid]\n";
+	cerr << "       " << name << " -c [-x] [-j regions] [grid]\n";
+	cerr << "       " << name << " -E seconds [-x] [-j regions] [-K cages] [grid]\n";
+	cerr << "       " << name << " -u count [-o output] [-x] [-j regions] [grid]\n";
+	cerr << "       " << name << " -B [-o output] [-x] [-j regions] [grid]\n";
+	cerr << "       " << name << " -R dimension:min:max:count [-o output] [-x]\n";
+	cerr << "       " << name << " -m [-o output] [-x] [-j regions] [puzzles]\n";
+	cerr << "       " << name << " -v solutions [-o output] [-x] [-j regions] [puzzles]\n";
+	cerr << "       " << name << " -p queue:depth [-x] [-j regions] [grid]\n";
+	cerr << "       " << name << " -w queue [-e text|binary|count] [-n hypotheses] [-L seconds] [-x] [-j regions]\n";
+	cerr << "       " << name << " -g queue [-e text|binary|count] [-L seconds] [-o output]\n";
+	cerr << "       " << name << " -S script [-b bank] [-o output]\n";
+	cerr << "       " << name << " -T|-F trace [-o output]\n";
+	cerr << "  -b bank   Puzzle bank used to start new games, default is $SUDOKU_BANK or ~/.sudoku-bank\n";
+	cerr << "  -r d:l:n  Generate n puzzles of dimension d and difficulty l in the bank and exit\n";
+	cerr << "  -l        List the content of the bank and exit\n";
+	cerr << "  -R d:a:b:n Generate n puzzles of dimension d whose score of difficulty is between a and b, write them one per line with their rating and exit\n";
+	cerr << "  -e format Enumerate all the solutions of the grid (read from the file or the standard input) in the format text, binary, delta, count (number of solutions only) or classes (one solution per class of symmetric solutions, with the size of the class) and exit\n";
+	cerr << "  -k checkpoint Save the state of the enumeration in the checkpoint file, and resume it from there if the file exists\n";
+	cerr << "  -i seconds Number of seconds between two checkpoints, default is 60\n";
+	cerr << "  -s        Solve the grid (read from the file or the standard input), tell if the solution is unique and exit\n";
+	cerr << "  -c        Count the solutions of the grid (read from the file or the standard input) without enumerating them and exit\n";
+	cerr << "  -E seconds Estimate, within the given time, the number of hypotheses, solutions and seconds of the enumeration of the solutions of the grid (read from the file or the standard input), with the number of units of a split at each depth, and exit\n";
+	cerr << "  -u count  Draw count solutions of the grid (read from the file or the standard input) uniformly at random, write them one per line and exit\n";
+	cerr << "  -B        Write the values each cell of the grid (read from the file or the standard input) holds in at least one solution, without enumerating them, and exit\n";
+	cerr << "  -m        Solve many puzzles given one per line (81 characters for a 9x9 grid, '.' or '0' for empty cells) and exit\n";
+	cerr << "  -v solutions Check the solutions (one per line, or binary stream) against the puzzles given one per line, write the indexes of the invalid ones and exit\n";
+	cerr << "  -p q:d    Split the enumeration of the solutions of the grid in units at depth d of the search, written in the new queue directory q, and exit\n";
+	cerr << "  -w queue  Solve the units of the queue until none is left and exit, several processes can work on the same queue\n";
+	cerr << "  -n hypotheses Number of hypotheses after which a unit of a queue is split, default is 1000000\n";
+	cerr << "  -L seconds Number of seconds after which a unit of a queue claimed by a process which stopped answering is solved again, default is 3600\n";
+	cerr << "  -g queue  Gather the solutions of the units of the queue, in the order of the enumeration, and exit\n";
+	cerr << "  -d dimacs Write the grid as a boolean formula in DIMACS format and exit\n";
+	cerr << "  -a algorithm Solving algorithm, backtrack (default) or cdcl (clause learning, for large grids)\n";
+	cerr << "  -o output File where the solutions are written, default is the standard output\n";
+	cerr << "  -x        The two main diagonals of the grid must hold different values too\n";
+	cerr << "  -j regions File giving the number of the region of each cell, for a jigsaw grid\n";
+	cerr << "  -K cages  File giving the number of the cage of each cell followed by the line of the sums of the cages, for a killer grid\n";
+	cerr << "  -t trace  Record the events of the searches and write them in the trace file at exit, default is $SUDOKU_TRACE\n";
+	cerr << "  -S script Replay the key script (or \"default\") on the interface in a pseudo-terminal, write the times and the bytes of each action and exit\n";
+	cerr << "  -T trace  Convert a trace file to the Chrome trace-event format and exit\n";
+	cerr << "  -F trace  Convert a trace file to folded stacks for flame graphs and exit\n";
+}
+
+/**
+ * \brief Read the grid given on the command line
+ *
+ * The grid is read from the file given as the first non-option argument, or from the standard input if there is none.
+ * \param argc Number of arguments in command line
+ * \param argv Array of arguments in command line
+ * \param regions Path of the file holding the regions of a jigsaw grid, or empty string for a grid with boxes
+ * \param diagonals Tell if the two main diagonals are units of the grid
+ * \param cages Path of the file holding the cages of a killer grid, see Geometry::read_cages, or empty string for a grid without cages
+ * \return Grid read
  */
+Grid read_grid(int argc,char **argv,const string &regions,bool diagonals,const string &cages) {
+	shared_ptr<const Geometry> geometry;
+	if (!regions.empty()) {
+		ifstream ifs(regions);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+regions+".");
+		geometry=Geometry::read_regions(ifs,diagonals);
+	}
+	Grid grid;
+	if (optind<argc) {
+		ifstream ifs(argv[optind]);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,string("Unable to open ")+argv[optind]+".");
+		grid.read_from_stream(ifs,geometry);
+	} else grid.read_from_stream(cin,geometry);
+	if (diagonals && !grid.geometry().diagonals()) {	// The boxes are only known once the grid is read
+		Grid x(Geometry::rectangular(grid.geometry().box_rows(),grid.geometry().box_columns(),true));
+		for (size_t i=0;i<grid.dim2();++i) for (size_t j=0;j<grid.dim2();++j) if (grid(i,j)->value!=0) x.set_value(i,j,grid(i,j)->value,true);
+		grid=std::move(x);
+	}
+	if (!cages.empty()) {
+		ifstream ifs(cages);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+cages+".");
+		Grid k(Geometry::read_cages(ifs,grid.geometry()));
+		for (size_t i=0;i<grid.dim2();++i) for (size_t j=0;j<grid.dim2();++j) if (grid(i,j)->value!=0) k.set_value(i,j,grid(i,j)->value,true);
+		return k;
+	}
+	return grid;
+}
 
+/**
+ * \brief Pack a grid given on a line
+ *
+ * The line holds one character per cell, row by row, in the format of Grid::read_line.
+ * \param line Line to read
+ * \param geometry Geometry of the grids, it is found from the line if it is still null
+ * \param diagonals Tell if the two main diagonals are units of the grids, only used when the geometry is found from the line
+ * \param values Vector to which the values of the cells are appended, 0 for the empty cells
+ */
+void pack_line(const string &line,shared_ptr<const Geometry> &geometry,bool diagonals,vector<unsigned char> &values) {
+	if (!geometry) {
+		Grid first;
+		first.read_line(line);
+		geometry=first.shared_geometry();
+		if (diagonals) geometry=Geometry::rectangular(geometry->box_rows(),geometry->box_columns(),true);
+	}
+	if (line.size()!=geometry->ncells()) throw SudokuException(SudokuException::FORMAT_ERROR,"All the grids must have the same dimension.");
+	for (char c:line) {
+		unsigned char v;
+		if (c=='.' || c=='0') v=0;
+		else if (c>='1' && c<='9') v=c-'0';
+		else if (c>='A' && c<='Z') v=c-'A'+10;
+		else throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid character in the line.");
+		values.push_back(v);
+	}
+}
 
-/* 	Grid *grid=new Grid(3);
- * 	grid->solve(Grid::FIND_ANY);
- * 	delete grid;
+/**
+ * \brief Solve many puzzles given one per line
+ *
+ * The puzzles are read from the file given as the first non-option argument, or from the standard input if there is none. They are solved by batches with BatchSolver, and the solution of each puzzle is written on a line, or an empty line if it has no solution.
+ * \param argc Number of arguments in command line
+ * \param argv Array of arguments in command line
+ * \param regions Path of the file holding the regions of a jigsaw grid, or empty string for grids with boxes
+ * \param diagonals Tell if the two main diagonals are units of the grids
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
  */
+int solve_batch(int argc,char **argv,const string &regions,bool diagonals,const string &output) {
+	shared_ptr<const Geometry> geometry;
+	if (!regions.empty()) {
+		ifstream ifs(regions);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+regions+".");
+		geometry=Geometry::read_regions(ifs,diagonals);
+	}
+	ifstream ifs;
+	if (optind<argc) {
+		ifs.open(argv[optind]);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,string("Unable to open ")+argv[optind]+".");
+	}
+	istream &in=(optind<argc)?ifs:cin;
+	// The puzzles are packed directly from the lines, the first one is also read as a grid to find the geometry
+	vector<unsigned char> puzzles;
+	size_t count=0;
+	string line;
+	while (getline(in,line)) {
+		if (line.empty()) continue;
+		pack_line(line,geometry,diagonals,puzzles);
+		++count;
+	}
+	if (count==0) return 0;
+	vector<unsigned char> solutions(puzzles.size());
+	auto start=chrono::steady_clock::now();
+	size_t n=BatchSolver(geometry).solve(puzzles.data(),count,solutions.data());
+	double elapsed=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	size_t ncells=geometry->ncells();
+	for (size_t i=0;i<count;++i) {
+		const unsigned char *solution=&solutions[i*ncells];
+		if (solution[0]!=0) for (size_t c=0;c<ncells;++c) out << (char)((solution[c]<=9)?'0'+solution[c]:'A'+solution[c]-10);
+		out << '\n';
+	}
+	cerr << n << " puzzles solved out of " << count << " in " << elapsed << " s\n";
+	return (n==count)?0:1;
+}
 
+/**
+ * \brief Check many solutions against their puzzles
+ *
+ * The puzzles are read one per line from the file given as the first non-option argument, or from the standard input if there is none. The solutions are read from their file, either one per line like the puzzles (as written by solve_batch, an empty line counting as a missing solution) or as a stream of the binary format of BinarySink. The solutions are paired with the puzzles in order, except when a single puzzle is given, in which case all the solutions are checked against it, like the enumerated solutions of a grid. The solutions are streamed by blocks, so the files may hold millions of them. The indexes of the invalid solutions, starting from 1, are written one per line. A malformed line of solution does not stop the check, it is reported as an invalid solution and its index is followed by the reason of the rejection.
+ * \param argc Number of arguments in command line
+ * \param argv Array of arguments in command line
+ * \param solutions Path of the file holding the solutions
+ * \param regions Path of the file holding the regions of a jigsaw grid, or empty string for grids with boxes
+ * \param diagonals Tell if the two main diagonals are units of the grids
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int verify_batch(int argc,char **argv,const string &solutions,const string &regions,bool diagonals,const string &output) {
+	shared_ptr<const Geometry> geometry;
+	if (!regions.empty()) {
+		ifstream ifs(regions);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+regions+".");
+		geometry=Geometry::read_regions(ifs,diagonals);
+	}
+	ifstream ifs;
+	if (optind<argc) {
+		ifs.open(argv[optind]);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,string("Unable to open ")+argv[optind]+".");
+	}
+	istream &in=(optind<argc)?ifs:cin;
+	vector<unsigned char> puzzles;
+	size_t npuzzles=0;
+	string line;
+	while (getline(in,line)) {
+		if (line.empty()) continue;
+		pack_line(line,geometry,diagonals,puzzles);
+		++npuzzles;
+	}
+	if (npuzzles==0) throw SudokuException(SudokuException::FORMAT_ERROR,"No puzzle to check the solutions against.");
+	size_t ncells=geometry->ncells();
+	// The binary streams start with a magic string which can not be the beginning of a line
+	ifstream sfs(solutions,ios::binary);
+	if (!sfs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+solutions+".");
+	char magic[8]={0};
+	sfs.read(magic,sizeof(magic));
+	bool binary=(sfs.gcount()==sizeof(magic) && memcmp(magic,"SUDOKUSL",sizeof(magic))==0);
+	sfs.clear();
+	sfs.seekg(0);
+	unique_ptr<SolutionReader> reader;
+	if (binary) {
+		reader.reset(new SolutionReader(sfs));
+		if (reader->dim2()!=geometry->dim2()) throw SudokuException(SudokuException::FORMAT_ERROR,"The solutions and the puzzles must have the same dimension.");
+	}
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	Verifier verifier(geometry);
+	const size_t block=4096;
+	vector<unsigned char> block_puzzles,block_solutions,results(block),values;
+	vector<string> reasons(block);	// Reasons of the rejection of the malformed lines of the current block
+	size_t count=0,nvalid=0;
+	double elapsed=0;
+	bool more=true;
+	while (more) {
+		// Read a block of solutions and the matching puzzles
+		block_solutions.clear();
+		block_puzzles.clear();
+		size_t n=0;
+		while (n<block) {
+			if (binary) {
+				if (!reader->next(values)) break;
+				block_solutions.insert(block_solutions.end(),values.begin(),values.end());
+			} else {
+				if (!getline(sfs,line)) break;
+				size_t size=block_solutions.size();
+				reasons[n].clear();
+				if (!line.empty()) try {
+					pack_line(line,geometry,diagonals,block_solutions);
+				} catch (SudokuException &e) {
+					// A malformed line is reported as an invalid solution, its values are left empty so that the verifier rejects it
+					reasons[n]=e.message;
+					block_solutions.resize(size);
+				}
+				block_solutions.resize(size+ncells,0);
+			}
+			if (npuzzles>1) {
+				if (count+n>=npuzzles) throw SudokuException(SudokuException::FORMAT_ERROR,"There are more solutions than puzzles.");
+				block_puzzles.insert(block_puzzles.end(),puzzles.begin()+(count+n)*ncells,puzzles.begin()+(count+n+1)*ncells);
+			} else block_puzzles.insert(block_puzzles.end(),puzzles.begin(),puzzles.end());
+			++n;
+		}
+		more=(n==block);
+		auto start=chrono::steady_clock::now();
+		nvalid+=verifier.check(block_puzzles.data(),block_solutions.data(),n,results.data());
+		elapsed+=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+		for (size_t i=0;i<n;++i) if (results[i]==0) {
+			out << count+i+1;
+			if (!binary && !reasons[i].empty()) out << ' ' << reasons[i];
+			out << '\n';
+		}
+		count+=n;
+	}
+	if (npuzzles>1 && count<npuzzles) throw SudokuException(SudokuException::FORMAT_ERROR,"There are fewer solutions than puzzles.");
+	cerr << nvalid << " valid solutions out of " << count << " in " << elapsed << " s\n";
+	return (nvalid==count)?0:1;
+}
 
-/* 	Grid grid=Grid::generate(3,0);
- * 	cout << "Grille :\n" << grid;
- * 	cout << "\nSolution :\n";
- * 	grid.solve(Grid::FIND_ONE);
+/**
+ * \brief Solve a grid with the chosen algorithm
+ *
+ * \param grid Grid to solve
+ * \param algorithm Solving algorithm, "backtrack" or "cdcl"
+ * \param type Type of solving, see Grid::SolveType
+ * \param callback Callback function applied on each solution
+ * \return Number of solutions found
  */
+size_t solve_with(const Grid &grid,const string &algorithm,Grid::SolveType type,std::function<void(const Grid&)> callback) {
+	if (algorithm!="cdcl") return grid.solve(type,callback);
+	SatGrid sat(grid);
+	size_t n=sat.solve(type,callback);
+	cerr << sat.solver().nconflicts() << " conflicts, " << sat.solver().ndecisions() << " decisions, " << sat.solver().nrestarts() << " restarts\n";
+	return n;
+}
 
-	CursesGui gui;
-	gui.run();
+/**
+ * \brief Solve a grid and check that its solution is unique
+ *
+ * \param grid Grid to solve
+ * \param algorithm Solving algorithm, "backtrack" or "cdcl"
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int solve(const Grid &grid,const string &algorithm,const string &output) {
+	Grid first;
+	size_t n=solve_with(grid,algorithm,Grid::FIND_UNIQUE,[&first](const Grid &g) {if (first.dim2()==0) first=g;});
+	if (n==0) {
+		cerr << "No solution found\n";
+		return 1;
+	}
+	if (output.empty()) first.write_to_stream(cout);
+	else {
+		ofstream ofs(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+		first.write_to_stream(ofs);
+	}
+	cerr << ((n==1)?"The solution is unique\n":"The grid has several solutions\n");
+	return 0;
+}
+
+/**
+ * \brief Write a grid as a boolean formula
+ *
+ * \param grid Grid to write
+ * \param output Path of the output file, or "-" for the standard output
+ * \return Exit code of the program
+ */
+int write_dimacs(const Grid &grid,const string &output) {
+	SatGrid sat(grid);
+	if (output=="-") sat.write_dimacs(cout);
+	else {
+		ofstream ofs(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+		sat.write_dimacs(ofs);
+	}
+	return 0;
+}
+
+/**
+ * \brief Count the solutions of a grid
+ *
+ * \param grid Grid whose solutions are counted
+ * \return Exit code of the program
+ */
+int count(const Grid &grid) {
+	ModelCounter counter(grid);
+	cout << to_string(counter.count()) << '\n';
+	cerr << counter.nbranches() << " branches, " << counter.nsplits() << " splits, " << counter.nhits() << " cache hits\n";
+	return 0;
+}
+
+/**
+ * \brief Draw solutions of a grid uniformly at random
+ *
+ * The solutions are written one per line, in the format of Grid::write_line. The same solution may be drawn several times.
+ * \param grid Grid whose solutions are drawn
+ * \param count Number of solutions to draw
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int sample(const Grid &grid,size_t count,const string &output) {
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	ModelCounter counter(grid);
+	mt19937 generator(random_seed());
+	vector<elem_t> values;
+	string line;
+	auto start=chrono::steady_clock::now();
+	for (size_t k=0;k<count;++k) {
+		if (!counter.sample(generator,values)) {
+			cerr << "No solution found\n";
+			return 1;
+		}
+		line.clear();
+		for (elem_t v:values) line.push_back((char)((v<=9)?'0'+v:'A'+v-10));
+		out << line << '\n';
+	}
+	double elapsed=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	cerr << count << " solutions drawn in " << elapsed << " s (" << count/elapsed << " solutions/s)\n";
+	return 0;
+}
+
+/**
+ * \brief Estimate the size of the search for all the solutions of a grid
+ *
+ * The estimates are written one per line, with their errors, followed by the estimated number of units given by a split of the search at each depth (see option -p).
+ * \param grid Grid whose search is estimated
+ * \param seconds Time budget of the estimation
+ * \return Exit code of the program
+ */
+int estimate(const Grid &grid,double seconds) {
+	Grid::Estimate e=grid.estimate(seconds);
+	cout << "probes\t" << e.probes << '\n';
+	cout << "hypotheses\t" << e.nodes << "\t+/- " << e.nodes_error << '\n';
+	cout << "solutions\t" << e.solutions << "\t+/- " << e.solutions_error << '\n';
+	cout << "seconds\t" << e.seconds << '\n';
+	for (size_t d=0;d<e.profile.size();++d) cout << "depth " << d+1 << '\t' << e.profile[d] << '\n';
+	return 0;
+}
+
+/**
+ * \brief Analyse the values of all the solutions of a grid
+ *
+ * The result is written row by row, with the cells separated by tabulations. Each cell is written as the list of the values it holds in at least one solution, with the characters of Grid::write_line, so that a cell with a single value is forced in all the solutions.
+ * \param grid Grid to analyse
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int backbone(const Grid &grid,const string &output) {
+	Backbone analysis(grid);
+	if (!analysis.solvable()) {
+		cerr << "No solution found\n";
+		return 1;
+	}
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	size_t d2=grid.dim2();
+	size_t nforced=0;
+	for (size_t i=0;i<d2;++i) {
+		for (size_t j=0;j<d2;++j) {
+			if (j>0) out << '\t';
+			for (elem_t v=1;v<=d2;++v) if (analysis.supported(i,j,v)) out << (char)((v<=9)?'0'+v:'A'+v-10);
+			if (grid(i,j)->value==0 && analysis.forced(i,j)!=0) ++nforced;
+		}
+		out << '\n';
+	}
+	cerr << nforced << " empty cells forced, " << analysis.nsearches() << " searches\n";
 	return 0;
 }
+
+/**
+ * \brief Generate puzzles in a band of difficulty
+ *
+ * Each puzzle is written on a line in the format of Grid::write_line, followed by its score, the deductions needed (0 for naked singles, 1 for hidden singles, 2 for a search), and the number and the depth of the hypotheses of the search, separated by tabulations.
+ * \param request Dimension, band of scores and number of the puzzles
+ * \param diagonals Tell if the diagonals of the grids must hold different values
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int generate_rated(const RatedRequest &request,bool diagonals,const string &output) {
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	shared_ptr<const Geometry> geometry=Geometry::standard(request.dimension,diagonals);
+	size_t ncandidates=0;
+	auto start=chrono::steady_clock::now();
+	for (size_t k=0;k<request.count;++k) {
+		Grid::Rating rating;
+		size_t n;
+		Grid puzzle=Grid::generate_rated(geometry,request.minscore,request.maxscore,&rating,0,false,0,&n);
+		ncandidates+=n;
+		out << puzzle.write_line() << '\t' << rating.score() << '\t' << rating.level << '\t' << rating.nodes << '\t' << rating.depth << '\n';
+	}
+	double elapsed=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+	cerr << request.count << " puzzles generated from " << ncandidates << " full grids in " << elapsed << " s (" << request.count/elapsed << " puzzles/s)\n";
+	return 0;
+}
+
+/**
+ * \brief Enumerate the classes of solutions of a grid
+ *
+ * Two solutions are in the same class if a symmetry of the grid turns one into the other, see SymmetryGroup. The representative of each class is written on a line in the format of Grid::write_line, followed by a tabulation and the number of solutions of the class.
+ * \param grid Grid whose solutions are enumerated
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int classes(const Grid &grid,const string &output) {
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	SymmetryGroup group(grid);
+	uint64_t total=0;
+	size_t n=group.enumerate([&out,&total](const Grid &solution,size_t size) {
+		out << solution.write_line() << '\t' << size << '\n';
+		total+=size;
+	});
+	cerr << n << " classes, " << total << " solutions (" << group.nmoves() << " symmetries of the cells, " << group.ninterchangeable() << " interchangeable values)\n";
+	return 0;
+}
+
+/**
+ * \brief Enumerate all the solutions of a grid
+ *
+ * With a checkpoint file, the state of the enumeration is saved periodically in the file, and an enumeration started with an existing checkpoint file resumes where the saved one stopped: the output is cut back to its size at the checkpoint and the following solutions are appended, so that it ends the same as if the enumeration had never been interrupted. The file is removed at the end of the enumeration.
+ * \param grid Grid to solve
+ * \param format Format of the output, "text", "binary", "delta", "count" or "classes"
+ * \param algorithm Solving algorithm, "backtrack" or "cdcl"
+ * \param output Path of the output file, or empty string for the standard output
+ * \param checkpoint Path of the checkpoint file, or empty string for an enumeration without checkpoints
+ * \param period Number of seconds between two checkpoints
+ * \return Exit code of the program
+ */
+int enumerate(const Grid &grid,const string &format,const string &algorithm,const string &output,const string &checkpoint,double period) {
+	if (format!="text" && format!="binary" && format!="delta" && format!="count" && format!="classes") {
+		cerr << "Unknown format " << format << '\n';
+		return 1;
+	}
+	if (format=="classes") {
+		if (algorithm!="backtrack" || !checkpoint.empty()) throw SudokuException(SudokuException::FORMAT_ERROR,"The classes of solutions are only enumerated with the backtrack algorithm and without checkpoints.");
+		return classes(grid,output);
+	}
+	Checkpoint state;
+	bool resumed=false;
+	if (!checkpoint.empty()) {
+		if (algorithm!="backtrack") throw SudokuException(SudokuException::FORMAT_ERROR,"Checkpoints are only available with the backtrack algorithm.");
+		if (output.empty() && format!="count") throw SudokuException(SudokuException::FORMAT_ERROR,"An output file is needed to resume an enumeration.");
+		resumed=state.read(checkpoint);
+		vector<unsigned char> packed(grid.dim2()*grid.dim2());
+		grid.write_packed(&packed[0]);
+		if (resumed && state.grid!=packed) throw SudokuException(SudokuException::FORMAT_ERROR,"The checkpoint "+checkpoint+" belongs to another grid.");
+		state.grid=packed;
+	}
+	int fd=1;
+	if (!output.empty()) {
+		fd=open(output.c_str(),resumed?O_WRONLY:(O_WRONLY | O_CREAT | O_TRUNC),0644);
+		if (fd<0) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+		if (resumed && (ftruncate(fd,state.offset)!=0 || lseek(fd,0,SEEK_END)<0)) throw SudokuException(SudokuException::IO_ERROR,"Unable to resume the output in "+output+".");
+	}
+	SolutionSink *sink;
+	if (format=="text") sink=new TextSink(fd);
+	else if (format=="binary") sink=new BinarySink(fd);
+	else if (format=="delta") sink=new DeltaSink(fd);
+	else sink=new CountSink();
+	uint64_t total;
+	if (checkpoint.empty()) {
+		solve_with(grid,algorithm,Grid::FIND_ALL,std::ref(*sink));
+		sink->finish();
+		total=sink->count;
+	} else {
+		if (resumed) {
+			sink->resume(state.previous);
+			cerr << "Resuming after " << state.solutions << " solutions and " << state.nodes << " hypotheses\n";
+		}
+		// The binary streams go on from the last solution written
+		bool binary=(format=="binary" || format=="delta");
+		auto put=[&state,sink,binary](const Grid &g) {
+			(*sink)(g);
+			if (binary) {
+				state.previous.resize(g.dim2()*g.dim2());
+				g.write_packed(&state.previous[0]);
+			}
+		};
+		uint64_t solutions=state.solutions,nodes=state.nodes;
+		auto save=[&state,sink,fd,solutions,nodes,&checkpoint](const vector<size_t> &path,size_t n) {
+			sink->finish();
+			state.path=path;
+			state.solutions=solutions+sink->count;
+			state.nodes=nodes+n;
+			state.offset=(fd==1)?0:lseek(fd,0,SEEK_CUR);
+			state.write(checkpoint);
+		};
+		vector<size_t> resume=state.path;
+		grid.enumerate(put,save,period,resume);
+		sink->finish();
+		total=solutions+sink->count;
+		remove(checkpoint.c_str());
+	}
+	if (format=="count") cout << total << '\n';
+	else cerr << total << " solutions\n";
+	delete sink;
+	if (fd!=1) close(fd);
+	return 0;
+}
+
+/**
+ * \brief Split the enumeration of the solutions of a grid in a queue of work units
+ *
+ * \param grid Grid whose solutions are enumerated
+ * \param queue Path of the directory of the queue, it must not exist yet
+ * \param depth Depth of the units in the search tree
+ * \return Exit code of the program
+ */
+int partition(const Grid &grid,const string &queue,size_t depth) {
+	size_t n=WorkQueue(queue).create(grid,depth);
+	cerr << n << " units written in " << queue << '\n';
+	return 0;
+}
+
+/**
+ * \brief Solve the units of a queue
+ *
+ * The units are claimed one after the other until none is pending. A unit which is not solved within the given number of hypotheses is replaced in the queue by the units of its next level, and its solutions found so far are dropped. Any number of processes can solve the units of the same queue.
+ * \param queue Path of the directory of the queue
+ * \param format Format of the solutions of the units, "text", "binary" or "count"
+ * \param regions Path of the file holding the regions of a jigsaw grid, or empty string for a grid with boxes
+ * \param diagonals Tell if the two main diagonals are units of the grid
+ * \param budget Number of hypotheses after which a unit is split
+ * \param lease Number of seconds after which the lease of a claimed unit expires
+ * \return Exit code of the program
+ */
+int work(const string &queue,const string &format,const string &regions,bool diagonals,size_t budget,size_t lease) {
+	if (format!="text" && format!="binary" && format!="count") {
+		cerr << "Unknown format " << format << " for a queue\n";
+		return 1;
+	}
+	WorkQueue q(queue,lease);
+	shared_ptr<const Geometry> geometry;
+	if (!regions.empty()) {
+		ifstream ifs(regions);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+regions+".");
+		geometry=Geometry::read_regions(ifs,diagonals);
+	}
+	string name,line;
+	size_t nsolved=0,nsplit=0;
+	uint64_t total=0;
+	while (q.claim(name,line)) {
+		if (!geometry) {
+			Grid first;
+			first.read_line(line);
+			geometry=first.shared_geometry();
+			if (diagonals) geometry=Geometry::rectangular(geometry->box_rows(),geometry->box_columns(),true);
+		}
+		Grid unit;
+		unit.read_line(line,geometry);
+		int fd=-1;
+		SolutionSink *sink;
+		if (format=="count") sink=new CountSink();
+		else {
+			fd=open(q.output(name).c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+			if (fd<0) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+q.output(name)+".");
+			if (format=="text") sink=new TextSink(fd);
+			else sink=new BinarySink(fd);
+		}
+		size_t n;
+		bool finished=unit.enumerate(std::ref(*sink),budget,n);
+		sink->finish();
+		delete sink;
+		if (fd>=0) close(fd);
+		if (finished) {
+			q.complete(name,n,fd>=0);
+			++nsolved;
+			total+=n;
+		} else {
+			if (fd>=0) remove(q.output(name).c_str());
+			vector<string> children;
+			unit.split(1,[&children](const Grid &g) {children.push_back(g.write_line());});
+			q.split(name,children);
+			++nsplit;
+		}
+	}
+	cerr << nsolved << " units solved with " << total << " solutions, " << nsplit << " units split\n";
+	return 0;
+}
+
+/**
+ * \brief Merge the results of the units of a queue
+ *
+ * The solutions of the units are written in the order of the names of the units, which is the order of the enumeration of the whole grid. The abandoned units are first moved back to the pending units, see WorkQueue::recover, so that the next workers solve them again.
+ * \param queue Path of the directory of the queue
+ * \param format Format of the solutions of the units, "text", "binary" or "count"
+ * \param output Path of the output file, or empty string for the standard output
+ * \param lease Number of seconds after which the lease of a claimed unit expires
+ * \return Exit code of the program
+ */
+int merge(const string &queue,const string &format,const string &output,size_t lease) {
+	WorkQueue q(queue,lease);
+	size_t recovered=q.recover();
+	if (recovered>0) cerr << recovered << " abandoned units moved back to the pending units\n";
+	size_t left=q.units("pending").size()+q.units("running").size();
+	if (left>0) {
+		cerr << left << " units are not solved yet\n";
+		return 1;
+	}
+	ofstream ofs;
+	if (!output.empty() && format!="count") {
+		ofs.open(output,ios::binary);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	uint64_t total=0;
+	bool header=false;
+	for (const string &name:q.units("done")) {
+		ifstream ifs(q.done(name));
+		uint64_t n;
+		if (!(ifs >> n)) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid result for the unit "+name+".");
+		total+=n;
+		if (format=="count" || n==0) continue;
+		ifstream sfs(q.done(name,".out"),ios::binary);
+		if (!sfs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open the solutions of the unit "+name+".");
+		if (format=="binary" && header) sfs.seekg(BinarySink::header_size);	// Only the first stream keeps its header
+		out << sfs.rdbuf();
+		header=true;
+	}
+	if (format=="count") cout << total << '\n';
+	else cerr << total << " solutions\n";
+	return 0;
+}
+
+/**
+ * \brief Default script of the interactive interface
+ *
+ * For each dimension, the script starts an empty grid, moves around it, fills the first row, asks for clues and for the solution, then does the same after a new game has been generated.
+ * \return Text of the script, in the format of ScriptDriver::read_script
+ */
+string default_script() {
+	ostringstream script;
+	for (size_t dim=3;dim<=4;++dim) {
+		size_t d2=dim*dim;
+		string size=" "+to_string(d2)+"x"+to_string(d2);
+		script << "menu\t\\e\n";
+		script << "new empty" << size << "\tN" << dim << "\\n\n";
+		script << "menu\t\\e\n";
+		for (size_t k=0;k<d2;++k) script << "right" << size << "\t<Right>\n";
+		for (size_t k=0;k<d2;++k) script << "down" << size << "\t<Down>\n";
+		for (size_t v=1;v<=d2;++v) {
+			script << "digit" << size << '\t' << (char)((v<=9)?'0'+v:'A'+v-10) << '\n';
+			script << "right" << size << "\t<Right>\n";
+		}
+		script << "menu\t\\e\n";
+		for (size_t k=0;k<3;++k) script << "clue" << size << "\tC\n";
+		script << "solve" << size << "\tS\n";
+		script << "new game" << size << "\tN" << dim << "10\\n\n";
+		for (size_t k=0;k<3;++k) script << "clue" << size << "\tC\n";
+		script << "solve" << size << "\tS\n";
+		script << "menu\t\\e\n";
+	}
+	script << "menu\t\\e\n";
+	script << "quit\tQ\n";
+	return script.str();
+}
+
+/**
+ * \brief Replay a script on the interactive interface
+ *
+ * The times and the number of bytes written to the terminal are summed up for each label of action, in the order of their first appearance: label, number of actions, median time to the first byte, median and maximal time to the end of the first frame, median and maximal time to the last byte in milliseconds, mean and total number of bytes. The first frame is the answer to the keys, while the last byte also counts the screens redrawn during a background generation, see ScriptDriver.
+ * \param script Path of the script, or "default" for the script of default_script
+ * \param bankpath Path of the puzzle bank, or empty string for none
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int drive(const string &script,const string &bankpath,const string &output) {
+	vector<ScriptDriver::Action> actions;
+	if (script=="default") {
+		istringstream iss(default_script());
+		actions=ScriptDriver::read_script(iss);
+	} else {
+		ifstream ifs(script);
+		if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+script+".");
+		actions=ScriptDriver::read_script(ifs);
+	}
+	ScriptDriver driver([&bankpath]() {
+		PuzzleBank *bank=bankpath.empty()?0:new PuzzleBank(bankpath);
+		CursesGui gui(bank);
+		gui.run();
+		delete bank;
+	});
+	vector<ScriptDriver::Measure> measures=driver.run(actions);
+	if (measures.size()<actions.size()+1) cerr << "The program stopped after " << measures.size()-1 << " actions out of " << actions.size() << '\n';
+	// Group the measures by label
+	vector<string> labels;
+	map<string,vector<ScriptDriver::Measure> > groups;
+	for (const ScriptDriver::Measure &m:measures) {
+		if (groups.find(m.label)==groups.end()) labels.push_back(m.label);
+		groups[m.label].push_back(m);
+	}
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	out << "action\tcount\tmedian_first_ms\tmedian_frame_ms\tmax_frame_ms\tmedian_last_ms\tmax_last_ms\tmean_bytes\ttotal_bytes\n";
+	for (const string &label:labels) {
+		vector<ScriptDriver::Measure> &g=groups[label];
+		vector<double> firsts,frames,latencies;
+		size_t bytes=0;
+		for (const ScriptDriver::Measure &m:g) {
+			firsts.push_back(m.first*1000);
+			frames.push_back(m.frame*1000);
+			latencies.push_back(m.latency*1000);
+			bytes+=m.bytes;
+		}
+		sort(firsts.begin(),firsts.end());
+		sort(frames.begin(),frames.end());
+		sort(latencies.begin(),latencies.end());
+		out << label << '\t' << g.size() << '\t' << firsts[firsts.size()/2] << '\t' << frames[frames.size()/2] << '\t' << frames.back() << '\t' << latencies[latencies.size()/2] << '\t' << latencies.back() << '\t' << bytes/g.size() << '\t' << bytes << '\n';
+	}
+	return (measures.size()==actions.size()+1)?0:1;
+}
+
+/**
+ * \brief Convert a trace file
+ *
+ * \param trace Path of the trace file
+ * \param chrome True for the Chrome trace-event format, false for folded stacks
+ * \param output Path of the output file, or empty string for the standard output
+ * \return Exit code of the program
+ */
+int convert_trace(const string &trace,bool chrome,const string &output) {
+	ifstream ifs(trace,ios::binary);
+	if (!ifs) throw SudokuException(SudokuException::IO_ERROR,"Unable to open "+trace+".");
+	ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+output+".");
+	}
+	ostream &out=output.empty()?cout:ofs;
+	if (chrome) Trace::write_chrome(ifs,out);
+	else Trace::write_folded(ifs,out);
+	return 0;
+}
+
+/**
+ * \brief Main program
+ *
+ * The main program starts the game and the main execution loop.
+ * \param argc Number of arguments in command line, including the name of the program
+ * \param argv Array of arguments in command line, the first one being the name of the program
+ */
+int main(int argc,char **argv) {
+	string bankpath;
+	if (getenv("SUDOKU_BANK")!=0) bankpath=getenv("SUDOKU_BANK");
+	else if (getenv("HOME")!=0) bankpath=string(getenv("HOME"))+"/.sudoku-bank";
+	vector<RefillRequest> refills;
+	RatedRequest rated={0,0,0,0};
+	bool list=false;
+	string format,output,regions,cages,dimacs,trace,converted,verified,checkpoint,queue,worked,gathered,script;
+	double period=60,budgeted=0;
+	size_t depth=0,budget=1000000,nsamples=0,lease=3600;
+	if (getenv("SUDOKU_TRACE")!=0) trace=getenv("SUDOKU_TRACE");
+	bool chrome=false;
+	string algorithm="backtrack";
+	bool diagonals=false,solving=false,batch=false,counting=false,analysing=false;
+	int opt;
+	while ((opt=getopt(argc,argv,"b:r:R:le:E:u:o:k:i:xj:K:smcBv:p:w:n:L:g:S:d:a:t:T:F:h"))!=-1) {
+		switch (opt) {
+			case 'b':
+				bankpath=optarg;
+				break;
+			case 'r': {
+				RefillRequest r;
+				if (sscanf(optarg,"%zu:%zu:%zu",&r.dimension,&r.difficulty,&r.count)!=3 || r.dimension<2) {
+					usage(argv[0]);
+					return 1;
+				}
+				refills.push_back(r);
+				break;
+			}
+			case 'R':
+				if (sscanf(optarg,"%zu:%zu:%zu:%zu",&rated.dimension,&rated.minscore,&rated.maxscore,&rated.count)!=4 || rated.dimension<2 || rated.minscore>rated.maxscore) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'l':
+				list=true;
+				break;
+			case 'e':
+				format=optarg;
+				break;
+			case 'o':
+				output=optarg;
+				break;
+			case 'k':
+				checkpoint=optarg;
+				break;
+			case 'i':
+				period=atof(optarg);
+				break;
+			case 'x':
+				diagonals=true;
+				break;
+			case 'j':
+				regions=optarg;
+				break;
+			case 'K':
+				cages=optarg;
+				break;
+			case 's':
+				solving=true;
+				break;
+			case 'm':
+				batch=true;
+				break;
+			case 'c':
+				counting=true;
+				break;
+			case 'B':
+				analysing=true;
+				break;
+			case 'u':
+				nsamples=strtoul(optarg,0,10);
+				if (nsamples==0) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'E':
+				budgeted=atof(optarg);
+				if (budgeted<=0) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'v':
+				verified=optarg;
+				break;
+			case 'p': {
+				string arg=optarg;
+				size_t colon=arg.rfind(':');
+				if (colon==string::npos || sscanf(arg.c_str()+colon+1,"%zu",&depth)!=1) {
+					usage(argv[0]);
+					return 1;
+				}
+				queue=arg.substr(0,colon);
+				break;
+			}
+			case 'w':
+				worked=optarg;
+				break;
+			case 'n':
+				budget=strtoul(optarg,0,10);
+				break;
+			case 'L':
+				lease=strtoul(optarg,0,10);
+				break;
+			case 'g':
+				gathered=optarg;
+				break;
+			case 'S':
+				script=optarg;
+				break;
+			case 'd':
+				dimacs=optarg;
+				break;
+			case 'a':
+				algorithm=optarg;
+				break;
+			case 't':
+				trace=optarg;
+				break;
+			case 'T':
+			case 'F':
+				converted=optarg;
+				chrome=(opt=='T');
+				break;
+			default:
+				usage(argv[0]);
+				return (opt=='h')?0:1;
+		}
+	}
+	if (algorithm!="backtrack" && algorithm!="cdcl") {
+		usage(argv[0]);
+		return 1;
+	}
+	if (!trace.empty()) Trace::enable();
+	int code=0;
+	try {
+		if (!converted.empty()) code=convert_trace(converted,chrome,output);
+		// Headless mode, solve a grid or enumerate its solutions
+		else if (batch) code=solve_batch(argc,argv,regions,diagonals,output);
+		else if (!verified.empty()) code=verify_batch(argc,argv,verified,regions,diagonals,output);
+		else if (!queue.empty()) code=partition(read_grid(argc,argv,regions,diagonals,cages),queue,depth);
+		else if (!worked.empty()) code=work(worked,format.empty()?"count":format,regions,diagonals,budget,lease);
+		else if (!gathered.empty()) code=merge(gathered,format.empty()?"count":format,output,lease);
+		else if (!script.empty()) code=drive(script,bankpath,output);
+		else if (rated.count>0) code=generate_rated(rated,diagonals,output);
+		else if (counting) code=count(read_grid(argc,argv,regions,diagonals,cages));
+		else if (nsamples>0) code=sample(read_grid(argc,argv,regions,diagonals,cages),nsamples,output);
+		else if (budgeted>0) code=estimate(read_grid(argc,argv,regions,diagonals,cages),budgeted);
+		else if (analysing) code=backbone(read_grid(argc,argv,regions,diagonals,cages),output);
+		else if (solving) code=solve(read_grid(argc,argv,regions,diagonals,cages),algorithm,output);
+		else if (!dimacs.empty()) code=write_dimacs(read_grid(argc,argv,regions,diagonals,cages),dimacs);
+		else if (!format.empty()) code=enumerate(read_grid(argc,argv,regions,diagonals,cages),format,algorithm,output,checkpoint,period);
+		// Headless mode, refill or list the bank
+		else if (!refills.empty() || list) {
+			PuzzleBank bank(bankpath);
+			for (auto r:refills) {
+				bank.refill(r.dimension,r.difficulty,r.count,[&r](size_t n) {
+					cerr << "\rGenerating grids of dimension " << r.dimension << " and difficulty " << r.difficulty << ": " << n << "/" << r.count << flush;
+				});
+				cerr << '\n';
+			}
+			if (list) bank.write_summary(cout);
+		} else {
+			// Interactive mode
+			PuzzleBank *bank=bankpath.empty()?0:new PuzzleBank(bankpath);
+			CursesGui gui(bank);
+			gui.run();
+			delete bank;
+		}
+		if (!trace.empty()) {
+			Trace::disable();
+			Trace::dump(trace);
+		}
+	} catch (SudokuException &e) {
+		cerr << e.what() << '\n';
+		return 1;
+	}
+	return code;
+}
@@ -0,0 +1,155 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  symmetry.cpp
+ *
+ *    Description:  Implementation of the symmetries of a grid and of the enumeration of its classes of solutions
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 02:31:07
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "symmetry.h"
+
+using namespace std;
+
+/**
+ * \brief Permutations of lines keeping their groups
+ *
+ * \param ngroups Number of groups of lines
+ * \param size Number of lines in each group
+ * \return All the permutations which move the groups as a whole and the lines inside each group, new line of each line
+ */
+static vector<vector<size_t> > line_maps(size_t ngroups,size_t size) {
+	vector<vector<size_t> > inner,outer;
+	vector<size_t> p(size);
+	for (size_t i=0;i<size;++i) p[i]=i;
+	do inner.push_back(p); while (next_permutation(p.begin(),p.end()));
+	p.resize(ngroups);
+	for (size_t i=0;i<ngroups;++i) p[i]=i;
+	do outer.push_back(p); while (next_permutation(p.begin(),p.end()));
+	vector<vector<size_t> > maps;
+	vector<size_t> choice(ngroups,0);
+	for (auto &groups:outer) {
+		fill(choice.begin(),choice.end(),0);
+		bool more=true;
+		while (more) {
+			vector<size_t> m(ngroups*size);
+			for (size_t g=0;g<ngroups;++g) for (size_t i=0;i<size;++i) m[g*size+i]=groups[g]*size+inner[choice[g]][i];
+			maps.push_back(m);
+			// Next combination of the permutations inside the groups
+			size_t g=0;
+			while (g<ngroups && ++choice[g]==inner.size()) choice[g++]=0;
+			more=(g<ngroups);
+		}
+	}
+	return maps;
+}
+
+SymmetryGroup::SymmetryGroup(const Grid &grid):_grid(grid),_dim2(grid.dim2()),_interchangeable(grid.dim2(),true),_ninterchangeable(0),_factorial(1),_image(_dim2*_dim2),_best(_dim2*_dim2) {
+	const Geometry &geometry=grid.geometry();
+	size_t d2=_dim2;
+	vector<unsigned char> clues(d2*d2);
+	grid.write_packed(&clues[0]);
+	vector<bool> given(d2+1,false);
+	for (unsigned char v:clues) if (v!=0) given[v]=true;
+	for (size_t v=1;v<=d2;++v) if (given[v]) _interchangeable[v-1]=false;
+	if (geometry.ncages()>0) _interchangeable.assign(d2,false);	// The sums of the cages tell the values apart
+	for (size_t v=0;v<d2;++v) if (_interchangeable[v]) _factorial*=++_ninterchangeable;
+	// Moves keeping the units, only the identity if the regions are not boxes
+	size_t r=geometry.box_rows(),c=geometry.box_columns();
+	if (r==0 || geometry.ncages()>0) {
+		_rowmaps=line_maps(1,1);
+		_rowmaps[0].resize(d2);
+		for (size_t i=0;i<d2;++i) _rowmaps[0][i]=i;
+		_columnmaps=_rowmaps;
+	} else {
+		_rowmaps=line_maps(c,r);
+		_columnmaps=line_maps(r,c);
+	}
+	vector<unsigned char> relabel(d2+1);
+	for (uint32_t a=0;a<_rowmaps.size();++a) for (uint32_t b=0;b<_columnmaps.size();++b) for (int t=0;t<((r!=0 && r==c && geometry.ncages()==0)?2:1);++t) {
+		Move move={a,b,t==1};
+		// Each clue must land on a clue, with a one-to-one relabelling of the values
+		fill(relabel.begin(),relabel.end(),0);
+		vector<bool> used(d2+1,false);
+		for (size_t v=1;v<=d2;++v) if (!_interchangeable[v-1] && !given[v]) {	// The values told apart by the cages only keep their value
+			relabel[v]=(unsigned char)v;
+			used[v]=true;
+		}
+		bool valid=true;
+		for (size_t x=0;x<d2*d2 && valid;++x) {
+			unsigned char v=clues[x],w=clues[image(move,x)];
+			if ((v==0)!=(w==0)) valid=false;
+			else if (v!=0) {
+				if (relabel[v]==0 && !used[w]) {
+					relabel[v]=w;
+					used[w]=true;
+				} else if (relabel[v]!=w) valid=false;
+			}
+		}
+		// The diagonals must land on the diagonals
+		if (valid && geometry.diagonals()) for (size_t k=0;k<2 && valid;++k) {
+			size_t x=image(move,geometry.unit(3*d2+k)[0]);
+			bool main=(x/d2==x%d2);
+			for (size_t i=0;i<d2 && valid;++i) {
+				size_t y=image(move,geometry.unit(3*d2+k)[i]);
+				valid=main?(y/d2==y%d2):(y/d2+y%d2==d2-1);
+			}
+		}
+		if (!valid) continue;
+		_moves.push_back(move);
+		_relabel.insert(_relabel.end(),relabel.begin(),relabel.end());
+	}
+}
+
+void SymmetryGroup::renumber(vector<unsigned char> &values) const {
+	unsigned char label[256]={0};
+	size_t next=0;
+	for (unsigned char &v:values) if (_interchangeable[v-1]) {
+		if (label[v]==0) {
+			while (!_interchangeable[next]) ++next;
+			label[v]=++next;
+		}
+		v=label[v];
+	}
+}
+
+bool SymmetryGroup::canonical(const Grid &solution,size_t &size) {
+	size_t n=_dim2*_dim2;
+	solution.write_packed(&_best[0]);
+	vector<unsigned char> values(_best);
+	renumber(_best);
+	// The class is kept if no move gives a smaller grid, the moves giving the same grid are counted for its size
+	size_t stabilizer=0;
+	for (size_t k=0;k<_moves.size();++k) {
+		const unsigned char *relabel=&_relabel[k*(_dim2+1)];
+		for (size_t x=0;x<n;++x) _image[image(_moves[k],x)]=_interchangeable[values[x]-1]?values[x]:relabel[values[x]];
+		renumber(_image);
+		int c=memcmp(&_image[0],&_best[0],n);
+		if (c<0) return false;
+		if (c==0) ++stabilizer;
+	}
+	size=_moves.size()/stabilizer*_factorial;
+	return true;
+}
+
+size_t SymmetryGroup::enumerate(function<void(const Grid&,size_t)> callback) {
+	size_t nclasses=0;
+	_grid.enumerate([&](const Grid &solution) {
+		size_t size;
+		if (!canonical(solution,size)) return;
+		++nclasses;
+		callback(solution,size);
+	},_interchangeable);
+	return nclasses;
+}
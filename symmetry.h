@@ -0,0 +1,111 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  symmetry.h
+ *
+ *    Description:  Definition of the symmetries of a grid and of the enumeration of its classes of solutions
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026 02:14:52
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  SYMMETRY_INC
+#define  SYMMETRY_INC
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "objects.h"
+
+/**
+ * \brief Symmetries of a grid
+ *
+ * The class finds the transformations which turn each solution of a grid into another solution of the same grid, and enumerates the solutions up to these transformations. A transformation moves the cells and relabels the values, and it keeps the grid if each clue lands on a clue, the values of the clues being relabelled consistently.
+ * The moves of the cells are taken among the ones keeping the units of a grid with rectangular boxes: permutations of the bands, of the rows inside each band, of the stacks and of the columns inside each stack, and transposition if the boxes are square. With diagonals, only the moves keeping the diagonals are used. Jigsaw and killer grids only have the identity. The values which appear in no clue (and in no cage) can be relabelled freely: they are the interchangeable values of Grid::enumerate, so that the search itself only finds one solution for each permutation of them.
+ * Two solutions are in the same class if a transformation turns one into the other. The class of a solution is represented by the smallest of the grids obtained by transforming the solution and renumbering its interchangeable values in the order of their first appearance, row by row. The size of the class follows from the number of transformations which leave this grid unchanged.
+ * The transformations are tried one by one on each solution, so the enumeration is meant for grids whose clues leave few symmetries, or for small grids. The empty 9x9 grid has more than three million moves of the cells.
+ */
+class SymmetryGroup {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor finds the transformations keeping the grid.
+		 * \param grid Grid whose solutions are enumerated
+		 */
+		SymmetryGroup(const Grid &grid);
+
+		size_t nmoves() const {return _moves.size();}	//!< Number of moves of the cells keeping the grid, including the identity
+		size_t ninterchangeable() const {return _ninterchangeable;}	//!< Number of values appearing in no clue
+		const std::vector<bool>& interchangeable() const {return _interchangeable;}	//!< Tell for each value, at index v-1 for value v, if it appears in no clue
+
+		/**
+		 * \brief Check if a solution represents its class
+		 *
+		 * \param solution Solution of the grid
+		 * \param size Variable receiving the number of solutions of the class, only set if the method returns true
+		 * \return True if the solution is the smallest of its class once its interchangeable values are renumbered
+		 */
+		bool canonical(const Grid &solution,size_t &size);
+
+		/**
+		 * \brief Enumerate the classes of solutions of the grid
+		 *
+		 * The solutions are enumerated by Grid::enumerate with the interchangeable values, and only the representatives of their classes are kept. The sizes of the classes add up to the number of solutions of the grid.
+		 * \param callback Callback function applied on the representative of each class and on the number of solutions of the class
+		 * \return Number of classes
+		 */
+		size_t enumerate(std::function<void(const Grid&,size_t)> callback);
+
+	private:
+		/**
+		 * \brief Move of the cells of a grid
+		 */
+		struct Move {
+			uint32_t rows;	//!< Index of the permutation of the rows in SymmetryGroup::_rowmaps
+			uint32_t columns;	//!< Index of the permutation of the columns in SymmetryGroup::_columnmaps
+			bool transpose;	//!< Tell if the grid is transposed before the rows and the columns are permuted
+		};
+
+		Grid _grid;	//!< Grid whose solutions are enumerated
+		size_t _dim2;	//!< Number of rows of the grid
+		std::vector<std::vector<size_t> > _rowmaps;	//!< Permutations of the rows keeping the bands, new row of each row
+		std::vector<std::vector<size_t> > _columnmaps;	//!< Permutations of the columns keeping the stacks, new column of each column
+		std::vector<Move> _moves;	//!< Moves keeping the grid
+		std::vector<unsigned char> _relabel;	//!< New value of each value for each move, Grid::dim2+1 entries per move, 0 for the interchangeable values
+		std::vector<bool> _interchangeable;	//!< Values appearing in no clue
+		size_t _ninterchangeable;	//!< Number of interchangeable values
+		size_t _factorial;	//!< Number of permutations of the interchangeable values
+		std::vector<unsigned char> _image;	//!< Transformed solution being checked
+		std::vector<unsigned char> _best;	//!< Renumbered solution being checked
+
+		/**
+		 * \brief Image of a cell by a move
+		 *
+		 * \param move Move of the cells
+		 * \param cell Index of the cell
+		 * \return Index of the cell where the cell goes
+		 */
+		size_t image(const Move &move,size_t cell) const {
+			size_t i=cell/_dim2,j=cell%_dim2;
+			if (move.transpose) std::swap(i,j);
+			return _rowmaps[move.rows][i]*_dim2+_columnmaps[move.columns][j];
+		}
+
+		/**
+		 * \brief Renumber the interchangeable values of a grid
+		 *
+		 * The interchangeable values are renumbered in increasing order of their first appearance, row by row.
+		 * \param values Packed grid, updated by the method
+		 */
+		void renumber(std::vector<unsigned char> &values) const;
+};
+
+#endif   /* ----- #ifndef SYMMETRY_INC  ----- */
@@ -0,0 +1,12 @@
+# Run the program and compare its standard output with a reference file
+#
+# Variables: PROGRAM (path of the program), ARGUMENTS (arguments separated by |), EXPECTED (path of the reference output)
+string(REPLACE "|" ";" arguments "${ARGUMENTS}")
+execute_process(COMMAND ${PROGRAM} ${arguments} OUTPUT_VARIABLE output ERROR_VARIABLE errors RESULT_VARIABLE result)
+if (NOT result MATCHES "^[01]$")
+	message(FATAL_ERROR "The program did not exit normally (${result}):\n${errors}")
+endif (NOT result MATCHES "^[01]$")
+file(READ ${EXPECTED} expected)
+if (NOT output STREQUAL expected)
+	message(FATAL_ERROR "Unexpected output (exit code ${result}):\n${output}\nExpected:\n${expected}\nErrors:\n${errors}")
+endif (NOT output STREQUAL expected)
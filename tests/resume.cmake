@@ -0,0 +1,36 @@
+# Interrupt an enumeration with checkpoints several times and check that its output is the same as without interruption
+#
+# Variables: PROGRAM (path of the program), GRID (path of the grid), WORK (directory of the files of the test)
+file(MAKE_DIRECTORY ${WORK})
+set(reference ${WORK}/reference.txt)
+set(resumed ${WORK}/resumed.txt)
+set(checkpoint ${WORK}/checkpoint)
+execute_process(COMMAND ${PROGRAM} -e text -o ${reference} ${GRID} RESULT_VARIABLE result ERROR_QUIET)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "The enumeration without checkpoint failed (${result}).")
+endif (NOT result EQUAL 0)
+# The enumeration is killed after a delay short enough to stop it before its end, whatever the speed of the build
+foreach (delay 0.5 0.2 0.1 0.05 0.02)
+	file(REMOVE ${resumed} ${checkpoint})
+	execute_process(COMMAND ${PROGRAM} -e text -o ${resumed} -k ${checkpoint} -i 0.01 ${GRID} TIMEOUT ${delay} RESULT_VARIABLE result ERROR_QUIET)
+	if (EXISTS ${checkpoint})
+		set(interval ${delay})
+		break()
+	endif (EXISTS ${checkpoint})
+endforeach (delay)
+if (NOT EXISTS ${checkpoint})
+	message(FATAL_ERROR "The enumeration could not be interrupted after a checkpoint.")
+endif (NOT EXISTS ${checkpoint})
+set(runs 1)
+while (EXISTS ${checkpoint})
+	if (runs GREATER 100)
+		message(FATAL_ERROR "The enumeration does not progress from its checkpoint.")
+	endif (runs GREATER 100)
+	execute_process(COMMAND ${PROGRAM} -e text -o ${resumed} -k ${checkpoint} -i 0.01 ${GRID} TIMEOUT ${interval} RESULT_VARIABLE result ERROR_QUIET)
+	math(EXPR runs "${runs}+1")
+endwhile (EXISTS ${checkpoint})
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${reference} ${resumed} RESULT_VARIABLE different)
+if (different)
+	message(FATAL_ERROR "The output of the enumeration resumed ${runs} times differs from the output without interruption.")
+endif (different)
+message(STATUS "Enumeration resumed ${runs} times")
@@ -0,0 +1,201 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  trace.cpp
+ *
+ *    Description:  Implementation of the binary trace of the searches
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 17:20:45
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include "trace.h"
+#include "objects.h"
+
+using namespace std;
+
+static const char trace_magic[8]={'S','U','D','O','K','U','T','R'};	//!< Magic string at the beginning of a trace file
+static const uint32_t trace_version=1;	//!< Version of the format of the trace files
+
+/**
+ * \brief Ring buffer of the events of a thread
+ */
+struct TraceBuffer {
+	vector<Trace::Event> events;	//!< Events, the size of the vector is a power of 2
+	uint64_t count;	//!< Number of events written since the buffer was created
+	uint32_t thread;	//!< Index of the thread in the order of their first event
+};
+
+atomic<bool> Trace::_enabled(false);
+static mutex tracemutex;	//!< Mutex protecting the list of buffers
+static vector<shared_ptr<TraceBuffer> > tracebuffers;	//!< Buffers of all the threads which recorded events since tracing was enabled
+static size_t tracecapacity=0;	//!< Number of events of each buffer
+static atomic<unsigned> tracegeneration(0);	//!< Number of calls to Trace::enable, used to detect the buffers of a previous trace
+static thread_local shared_ptr<TraceBuffer> localbuffer;	//!< Buffer of the current thread
+static thread_local unsigned localgeneration=0;	//!< Generation of the buffer of the current thread
+
+void Trace::enable(size_t capacity) {
+	lock_guard<mutex> lock(tracemutex);
+	size_t c=1;
+	while (c<capacity) c<<=1;
+	tracecapacity=c;
+	tracebuffers.clear();
+	++tracegeneration;
+	_enabled.store(true);
+}
+
+void Trace::write(EventType type,size_t depth,size_t row,size_t column,size_t value) {
+	if (!localbuffer || localgeneration!=tracegeneration.load(memory_order_relaxed)) {
+		lock_guard<mutex> lock(tracemutex);
+		localbuffer=make_shared<TraceBuffer>();
+		localbuffer->events.resize(tracecapacity);
+		localbuffer->count=0;
+		localbuffer->thread=tracebuffers.size();
+		tracebuffers.push_back(localbuffer);
+		localgeneration=tracegeneration.load();
+	}
+	TraceBuffer &b=*localbuffer;
+	Event &e=b.events[b.count & (b.events.size()-1)];
+	e.time=chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	e.row=row;
+	e.column=column;
+	e.depth=depth;
+	e.value=value;
+	e.type=type;
+	++b.count;
+}
+
+void Trace::dump(const string &path) {
+	ofstream out(path,ios::binary);
+	if (!out) throw SudokuException(SudokuException::IO_ERROR,"Unable to create "+path+".");
+	lock_guard<mutex> lock(tracemutex);
+	uint32_t header[2]={trace_version,(uint32_t)tracebuffers.size()};
+	out.write(trace_magic,sizeof(trace_magic));
+	out.write((const char*)header,sizeof(header));
+	for (auto &b:tracebuffers) {
+		uint64_t size=b->events.size();
+		uint64_t n=min(b->count,size);
+		uint32_t thread[2]={b->thread,0};
+		uint64_t counts[2]={b->count,n};
+		out.write((const char*)thread,sizeof(thread));
+		out.write((const char*)counts,sizeof(counts));
+		// Oldest events first, they are located just after the last event written when the buffer has wrapped around
+		for (uint64_t i=b->count-n;i<b->count;++i) out.write((const char*)&b->events[i & (size-1)],sizeof(Event));
+	}
+	if (!out) throw SudokuException(SudokuException::IO_ERROR,"Unable to write "+path+".");
+}
+
+/**
+ * \brief Read a trace file
+ *
+ * The function throws a SudokuException if the file is not valid.
+ * \param in Input stream holding a file written by Trace::dump
+ * \return Events of each thread, in chronological order
+ */
+static vector<vector<Trace::Event> > read_trace(istream &in) {
+	char magic[sizeof(trace_magic)];
+	uint32_t header[2];
+	if (!in.read(magic,sizeof(magic)) || memcmp(magic,trace_magic,sizeof(magic))!=0 || !in.read((char*)header,sizeof(header)) || header[0]!=trace_version) throw SudokuException(SudokuException::FORMAT_ERROR,"Invalid trace file.");
+	vector<vector<Trace::Event> > threads(header[1]);
+	for (auto &events:threads) {
+		uint32_t thread[2];
+		uint64_t counts[2];
+		if (!in.read((char*)thread,sizeof(thread)) || !in.read((char*)counts,sizeof(counts))) throw SudokuException(SudokuException::FORMAT_ERROR,"Truncated trace file.");
+		events.resize(counts[1]);
+		if (counts[1]>0 && !in.read((char*)&events[0],counts[1]*sizeof(Trace::Event))) throw SudokuException(SudokuException::FORMAT_ERROR,"Truncated trace file.");
+	}
+	return threads;
+}
+
+/**
+ * \brief Name of a cell
+ *
+ * \param e Event holding the coordinates of the cell
+ * \return Name of the cell, with rows and columns numbered from 1
+ */
+static string cell_name(const Trace::Event &e) {
+	ostringstream oss;
+	oss << 'r' << e.row+1 << 'c' << e.column+1;
+	return oss.str();
+}
+
+void Trace::write_chrome(istream &in,ostream &out) {
+	vector<vector<Event> > threads=read_trace(in);
+	uint64_t origin=numeric_limits<uint64_t>::max();
+	for (auto &events:threads) if (!events.empty()) origin=min(origin,events[0].time);
+	out << "{\"traceEvents\":[";
+	bool first=true;
+	auto emit=[&](const string &name,const char *phase,uint64_t time,size_t tid,size_t depth) {
+		out << (first?"\n":",\n") << "{\"name\":\"" << name << "\",\"cat\":\"search\",\"ph\":\"" << phase << "\",\"ts\":" << (time-origin)/1000 << '.' << (char)('0'+(time-origin)%1000/100) << (char)('0'+(time-origin)%100/10) << (char)('0'+(time-origin)%10) << ",\"pid\":1,\"tid\":" << tid;
+		if (phase[0]=='i') out << ",\"s\":\"t\"";
+		out << ",\"args\":{\"depth\":" << depth << "}}";
+		first=false;
+	};
+	for (size_t tid=0;tid<threads.size();++tid) {
+		size_t open=0;
+		for (auto &e:threads[tid]) {
+			string name=cell_name(e)+'='+to_string(e.value);
+			switch (e.type) {
+				case BRANCH:
+					emit(name,"B",e.time,tid,e.depth);
+					++open;
+					break;
+				case BACKTRACK:
+					if (open==0) break;	// The beginning of the hypothesis has been overwritten in the ring buffer
+					emit(name,"E",e.time,tid,e.depth);
+					--open;
+					break;
+				case DEDUCE:
+					emit("deduce "+name,"i",e.time,tid,e.depth);
+					break;
+				case DEADEND:
+					emit("dead end","i",e.time,tid,e.depth);
+					break;
+				case SOLUTION:
+					emit("solution","i",e.time,tid,e.depth);
+					break;
+			}
+		}
+		// Close the hypotheses still open at the end of the trace
+		for (;open>0;--open) emit("","E",threads[tid].back().time,tid,open-1);
+	}
+	out << "\n]}\n";
+}
+
+void Trace::write_folded(istream &in,ostream &out) {
+	vector<vector<Event> > threads=read_trace(in);
+	map<string,uint64_t> folded;
+	for (auto &events:threads) {
+		if (events.empty()) continue;
+		vector<string> stack(1,"solve");
+		string path="solve";
+		uint64_t last=events[0].time;
+		for (auto &e:events) {
+			folded[path]+=e.time-last;
+			last=e.time;
+			if (e.type==BRANCH) stack.push_back(cell_name(e));
+			else if (e.type==BACKTRACK && stack.size()>1) stack.pop_back();
+			else continue;
+			path=stack[0];
+			for (size_t i=1;i<stack.size();++i) path+=';'+stack[i];
+		}
+	}
+	for (auto &f:folded) if (f.second>=1000) out << f.first << ' ' << f.second/1000 << '\n';
+}
@@ -0,0 +1,138 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  trace.h
+ *
+ *    Description:  Definition of the binary trace of the searches
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 16:52:14
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  TRACE_INC
+#define  TRACE_INC
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <istream>
+#include <ostream>
+
+/**
+ * \brief Binary trace of the searches
+ *
+ * The class records the events of the searches of Grid::solve in memory, so that a slow search can be studied in a normal build. Tracing is disabled by default and it is enabled at runtime with Trace::enable. When it is disabled, recording an event costs a single relaxed atomic load.
+ * Each thread writes its events in its own ring buffer, without any lock. When a buffer is full, the oldest events are overwritten, so the trace always holds the end of the search. The buffers are written to a file by Trace::dump, and the file is converted offline by Trace::write_chrome (Chrome trace-event JSON, which can be opened in chrome://tracing or Perfetto) or by Trace::write_folded (folded stacks for flame graph tools).
+ */
+class Trace {
+	public:
+		/**
+		 * \brief Type of event
+		 */
+		enum EventType {
+			BRANCH,	//!< A hypothesis is tried, the value is set in the cell and the search goes one level deeper
+			BACKTRACK,	//!< A hypothesis has been explored, the search goes back to the previous level
+			DEDUCE,	//!< A value has been deduced in a cell
+			DEADEND,	//!< A contradiction has been found
+			SOLUTION	//!< A solution has been found
+		};
+
+		/**
+		 * \brief Event of the trace
+		 *
+		 * The structure is written as is in the trace files, with the byte order of the machine.
+		 */
+		struct Event {
+			uint64_t time;	//!< Time of the event in nanoseconds, from an arbitrary origin shared by all threads
+			uint16_t row;	//!< Row of the cell of the event
+			uint16_t column;	//!< Column of the cell of the event
+			uint16_t depth;	//!< Number of hypotheses above the event in the search tree
+			uint8_t value;	//!< Value of the event
+			uint8_t type;	//!< Type of the event, see Trace::EventType
+		};
+
+		/**
+		 * \brief Enable tracing
+		 *
+		 * The method discards the events recorded before and enables the recording. Each thread gets a new buffer on its next event.
+		 * \param capacity Number of events kept by each thread, rounded up to a power of 2
+		 */
+		static void enable(size_t capacity=1<<16);
+
+		/**
+		 * \brief Disable tracing
+		 *
+		 * The recorded events are kept until the next call to Trace::enable, so that they can still be dumped.
+		 */
+		static void disable() {_enabled.store(false);}
+
+		/**
+		 * \brief Tell if tracing is enabled
+		 *
+		 * \return True if the events are recorded
+		 */
+		static bool enabled() {return _enabled.load(std::memory_order_relaxed);}
+
+		/**
+		 * \brief Record an event
+		 *
+		 * \param type Type of the event
+		 * \param depth Depth of the event in the search tree
+		 * \param row Row of the cell of the event
+		 * \param column Column of the cell of the event
+		 * \param value Value of the event
+		 */
+		static void record(EventType type,size_t depth,size_t row=0,size_t column=0,size_t value=0) {
+			if (enabled()) write(type,depth,row,column,value);
+		}
+
+		/**
+		 * \brief Write the recorded events to a file
+		 *
+		 * The file starts with the magic string "SUDOKUTR", the version of the format and the number of buffers, each on 4 bytes. Each buffer follows with the index of its thread on 4 bytes, 4 unused bytes, the number of events written in the buffer since tracing was enabled on 8 bytes, the number of events kept on 8 bytes and the kept events in chronological order.
+		 * The method must be called when no search is running. It throws a SudokuException if the file cannot be written.
+		 * \param path Path of the file
+		 */
+		static void dump(const std::string &path);
+
+		/**
+		 * \brief Convert a trace file to the Chrome trace-event format
+		 *
+		 * Each hypothesis becomes a slice of its thread, from its Trace::BRANCH event to its Trace::BACKTRACK event, so that the slices are nested like the search tree. The other events are instant events.
+		 * \param in Input stream holding a file written by Trace::dump
+		 * \param out Output stream receiving the JSON document
+		 */
+		static void write_chrome(std::istream &in,std::ostream &out);
+
+		/**
+		 * \brief Convert a trace file to folded stacks
+		 *
+		 * Each line holds a path of the search tree, as the list of the cells of the hypotheses separated by semicolons, followed by the time spent in this path without going deeper, in microseconds. The hypotheses on the same cell are merged, so the result summarises where the search spends its time. It can be drawn by flame graph tools.
+		 * \param in Input stream holding a file written by Trace::dump
+		 * \param out Output stream receiving the folded stacks
+		 */
+		static void write_folded(std::istream &in,std::ostream &out);
+
+	private:
+		static std::atomic<bool> _enabled;	//!< Tell if the events are recorded
+
+		/**
+		 * \brief Record an event in the buffer of the current thread
+		 *
+		 * \param type Type of the event
+		 * \param depth Depth of the event in the search tree
+		 * \param row Row of the cell of the event
+		 * \param column Column of the cell of the event
+		 * \param value Value of the event
+		 */
+		static void write(EventType type,size_t depth,size_t row,size_t column,size_t value);
+};
+
+#endif   /* ----- #ifndef TRACE_INC  ----- */
@@ -0,0 +1,74 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verify.cpp
+ *
+ *    Description:  Implementation of the verification of solutions
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 22:24:37
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include "verify.h"
+
+using namespace std;
+
+Verifier::Verifier(shared_ptr<const Geometry> pgeometry):_geometry(pgeometry),_bits(pgeometry->ncells()),_columns(pgeometry->dim2()) {
+	size_t d2=pgeometry->dim2();
+	if (d2>64) throw SudokuException(SudokuException::FORMAT_ERROR,"Solutions can only be checked for grids of at most 64 rows.");
+	_full=(d2==64)?~0ull:((1ull<<d2)-1);
+}
+
+bool Verifier::check(const unsigned char *puzzle,const unsigned char *solution) {
+	const size_t d2=_geometry->dim2();
+	const size_t ncells=_geometry->ncells();
+	// The values must be in range and the clues must be kept, the masks are computed in the same pass (they are only used if all the values are in range)
+	unsigned char bad=0;
+	for (size_t c=0;c<ncells;++c) {
+		bad|=(unsigned char)(solution[c]-1)>=d2;
+		bad|=(puzzle[c]!=0)&(puzzle[c]!=solution[c]);
+		_bits[c]=1ull<<((solution[c]-1)&63);
+	}
+	if (bad) return false;
+	// Rows, and columns accumulated at the same time
+	uint64_t rows=_full;
+	for (size_t j=0;j<d2;++j) _columns[j]=0;
+	for (size_t i=0;i<d2;++i) {
+		const uint64_t *row=&_bits[i*d2];
+		uint64_t acc=0;
+		for (size_t j=0;j<d2;++j) {
+			acc|=row[j];
+			_columns[j]|=row[j];
+		}
+		rows&=acc;
+	}
+	uint64_t columns=_full;
+	for (size_t j=0;j<d2;++j) columns&=_columns[j];
+	if (rows!=_full || columns!=_full) return false;
+	// Regions and diagonals, the units following the rows and the columns
+	for (size_t u=2*d2;u<_geometry->nunits();++u) {
+		const size_t *cells=_geometry->unit(u);
+		uint64_t acc=0;
+		for (size_t i=0;i<d2;++i) acc|=_bits[cells[i]];
+		if (acc!=_full) return false;
+	}
+	return true;
+}
+
+size_t Verifier::check(const unsigned char *puzzles,const unsigned char *solutions,size_t count,unsigned char *results) {
+	const size_t ncells=_geometry->ncells();
+	size_t nvalid=0;
+	for (size_t k=0;k<count;++k) {
+		bool valid=check(puzzles+k*ncells,solutions+k*ncells);
+		if (results!=0) results[k]=valid?1:0;
+		if (valid) ++nvalid;
+	}
+	return nvalid;
+}
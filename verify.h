@@ -0,0 +1,72 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verify.h
+ *
+ *    Description:  Definition of the verification of solutions
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 22:08:51
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  VERIFY_INC
+#define  VERIFY_INC
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "objects.h"
+#include "geometry.h"
+
+/**
+ * \brief Checker of solutions
+ *
+ * The class checks that full grids are valid solutions of their puzzles, without solving the puzzles again. A solution is valid if each of its values is in range, if it keeps the clues of the puzzle and if each unit holds all the values. As a unit has as many cells as there are values, the last condition is checked by a bitwise OR of the values of the unit, which must give the mask of all the values.
+ * The grids are given in the packed format of Grid::write_packed. The clues and the rows are checked with loops on contiguous bytes, and the columns are accumulated row by row in an array of masks, so that these loops can be turned into vector instructions by the compiler. The regions and the diagonals are read through the tables of the geometry.
+ * An object must not be used by several threads at the same time.
+ */
+class Verifier {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * The constructor throws a SudokuException if the grids of the geometry have more than 64 rows.
+		 * \param pgeometry Geometry of the grids checked
+		 */
+		Verifier(std::shared_ptr<const Geometry> pgeometry);
+
+		/**
+		 * \brief Check a solution
+		 *
+		 * \param puzzle Packed puzzle, 0 for the empty cells
+		 * \param solution Packed solution
+		 * \return True if the solution is a valid full grid holding the clues of the puzzle
+		 */
+		bool check(const unsigned char *puzzle,const unsigned char *solution);
+
+		/**
+		 * \brief Check many solutions
+		 *
+		 * \param puzzles Buffer holding the packed puzzles one after the other
+		 * \param solutions Buffer holding the packed solutions one after the other, in the same order
+		 * \param count Number of puzzles
+		 * \param results Buffer receiving 1 for each valid solution and 0 for the others, may be null
+		 * \return Number of valid solutions
+		 */
+		size_t check(const unsigned char *puzzles,const unsigned char *solutions,size_t count,unsigned char *results=0);
+
+	private:
+		std::shared_ptr<const Geometry> _geometry;	//!< Geometry of the grids
+		uint64_t _full;	//!< Mask holding all the values
+		std::vector<uint64_t> _bits;	//!< Mask of the value of each cell of the solution being checked
+		std::vector<uint64_t> _columns;	//!< Values found so far in each column
+};
+
+#endif   /* ----- #ifndef VERIFY_INC  ----- */
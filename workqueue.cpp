@@ -0,0 +1,132 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  workqueue.cpp
+ *
+ *    Description:  Implementation of the queue of work units shared by several processes
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 23:58:30
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "workqueue.h"
+
+using namespace std;
+
+/**
+ * \brief Name of the host
+ *
+ * \return Name of the host running the process
+ */
+static string host_name() {
+	char name[256]={0};
+	gethostname(name,sizeof(name)-1);
+	return name;
+}
+
+size_t WorkQueue::create(const Grid &grid,size_t depth) {
+	if (mkdir(_path.c_str(),0755)!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to create the queue "+_path+".");
+	const char *states[3]={"pending","running","done"};
+	for (const char *state:states) if (mkdir((_path+"/"+state).c_str(),0755)!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to create the queue "+_path+".");
+	size_t n=0;
+	grid.split(depth,[this,&n](const Grid &unit) {
+		ostringstream name;
+		name << setw(8) << setfill('0') << n++;
+		write_file(_path+"/pending/"+name.str(),unit.write_line()+'\n');
+	});
+	return n;
+}
+
+bool WorkQueue::claim(std::string &name,std::string &line) {
+	recover();
+	// Another process may claim a unit between the listing and the renaming, the next one is tried then
+	for (const string &unit:units("pending")) {
+		string running=_path+"/running/"+unit;
+		if (rename((_path+"/pending/"+unit).c_str(),running.c_str())!=0) continue;
+		ifstream ifs(running.c_str());
+		if (!getline(ifs,line)) throw SudokuException(SudokuException::FORMAT_ERROR,"The unit "+running+" is empty.");
+		ifs.close();
+		write_file(running,line+"\nlease "+host_name()+' '+to_string(getpid())+' '+to_string(time(0))+'\n');
+		name=unit;
+		return true;
+	}
+	return false;
+}
+
+size_t WorkQueue::recover() {
+	string host=host_name();
+	time_t now=time(0);
+	size_t n=0;
+	for (const string &unit:units("running")) {
+		string running=_path+"/running/"+unit;
+		struct stat before,after;
+		if (stat(running.c_str(),&before)!=0) continue;	// The unit has been completed meanwhile
+		ifstream ifs(running.c_str());
+		string line,tag,owner;
+		long pid;
+		long long stamp;
+		bool abandoned;
+		if (getline(ifs,line) && ifs >> tag >> owner >> pid >> stamp && tag=="lease") abandoned=(now-stamp>(long long)_lease || (owner==host && kill(pid,0)!=0 && errno==ESRCH));
+		else abandoned=(now-before.st_ctime>(time_t)_lease);
+		ifs.close();
+		// The lease is rewritten in a new file, so a unit claimed again since it has been read is not taken from its new owner
+		if (!abandoned || stat(running.c_str(),&after)!=0 || after.st_ino!=before.st_ino) continue;
+		if (rename(running.c_str(),(_path+"/pending/"+unit).c_str())==0) ++n;
+	}
+	return n;
+}
+
+void WorkQueue::complete(const std::string &name,uint64_t nsolutions,bool solutions) {
+	if (solutions && rename(output(name).c_str(),done(name,".out").c_str())!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to write the solutions of the unit "+name+".");
+	write_file(done(name),to_string(nsolutions)+'\n');
+	remove((_path+"/running/"+name).c_str());
+}
+
+void WorkQueue::split(const std::string &name,const std::vector<std::string> &units) {
+	for (size_t i=0;i<units.size();++i) {
+		ostringstream child;
+		child << name << '.' << setw(4) << setfill('0') << i;
+		write_file(_path+"/pending/"+child.str(),units[i]+'\n');
+	}
+	remove((_path+"/running/"+name).c_str());
+}
+
+std::vector<std::string> WorkQueue::units(const std::string &state) const {
+	vector<string> names;
+	DIR *dir=opendir((_path+"/"+state).c_str());
+	if (dir==0) throw SudokuException(SudokuException::IO_ERROR,"Unable to read the queue "+_path+".");
+	while (dirent *entry=readdir(dir)) {
+		string file=entry->d_name;
+		if (file.empty() || file[0]=='.' || file.find(".tmp")!=string::npos || file.find(".out")!=string::npos) continue;
+		names.push_back(file);
+	}
+	closedir(dir);
+	sort(names.begin(),names.end());
+	return names;
+}
+
+void WorkQueue::write_file(const std::string &ppath,const std::string &content) const {
+	string tmppath=ppath+".tmp";
+	ofstream ofs(tmppath.c_str(),ios::trunc);
+	ofs << content;
+	ofs.close();
+	if (!ofs || rename(tmppath.c_str(),ppath.c_str())!=0) throw SudokuException(SudokuException::IO_ERROR,"Unable to write "+ppath+".");
+}
@@ -0,0 +1,131 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  workqueue.h
+ *
+ *    Description:  Definition of the queue of work units shared by several processes
+ *
+ *        Version:  1.0
+ *        Created:  18/10/2026 23:41:52
+ *       Revision:  none
+ *       Compiler:  g++
+ *
+ *         Author:  François Hissel
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#ifndef  WORKQUEUE_INC
+#define  WORKQUEUE_INC
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "objects.h"
+
+/**
+ * \brief Queue of work units in a directory
+ *
+ * The queue splits the enumeration of the solutions of a grid in work units, given by Grid::split, which can be solved by any number of processes, on one machine or on several machines sharing the directory. The directory holds three subdirectories:
+ * - pending, with one file for each unit waiting to be solved, holding the unit in the format of Grid::write_line,
+ * - running, where the units are moved by the process which solves them,
+ * - done, with a file for each solved unit holding its number of solutions, and the file of its solutions with the extension ".out" if they are written.
+ * A unit is claimed by renaming its file from pending to running, which only succeeds for one process. The process then adds to the file a lease with the name of its host, its pid and the time of the claim. The units left in running by a process which has been killed are moved back to pending to be solved again, as soon as the process is found dead if it ran on the same host, or when the lease expires otherwise. The duration of the leases must therefore be longer than the time taken by a unit, or the unit may be solved twice, which wastes time but gives the same result. A unit which takes too long is replaced by the units of its next level, whose names are the name of the unit followed by their index, so that the order of the names is the order of the solutions.
+ */
+class WorkQueue {
+	public:
+		/**
+		 * \brief Standard constructor
+		 *
+		 * \param ppath Path of the directory of the queue
+		 * \param please Number of seconds after which the lease of a claimed unit expires
+		 */
+		WorkQueue(const std::string &ppath,size_t please=3600):_path(ppath),_lease(please) {}
+
+		/**
+		 * \brief Fill the queue with the units of a grid
+		 *
+		 * The method creates the directory of the queue, which must not exist yet, and it throws a SudokuException if it can not be created.
+		 * \param grid Grid whose solutions are enumerated
+		 * \param depth Depth of the units in the search tree, see Grid::split
+		 * \return Number of units
+		 */
+		size_t create(const Grid &grid,size_t depth);
+
+		/**
+		 * \brief Claim a unit
+		 *
+		 * The method first moves back to pending the units whose lease has expired, see WorkQueue::recover, then it claims the first pending unit and writes its lease.
+		 * \param name Variable receiving the name of the unit
+		 * \param line Variable receiving the unit, in the format of Grid::write_line
+		 * \return True if a unit has been claimed, false if no unit is pending
+		 */
+		bool claim(std::string &name,std::string &line);
+
+		/**
+		 * \brief Move the abandoned units back to pending
+		 *
+		 * A running unit is abandoned if its lease is older than the duration of the leases, or if its owner ran on this host and does not exist anymore. A unit whose lease has not been written yet is only abandoned after the duration of the leases since it has been claimed.
+		 * \return Number of units moved back to pending
+		 */
+		size_t recover();
+
+		/**
+		 * \brief Path of the file of the solutions of a unit
+		 *
+		 * The solutions must be written in this file before WorkQueue::complete is called.
+		 * \param name Name of the unit
+		 * \return Path of the temporary file of the solutions
+		 */
+		std::string output(const std::string &name) const {return _path+"/done/"+name+".out.tmp";}
+
+		/**
+		 * \brief Mark a claimed unit as solved
+		 *
+		 * \param name Name of the unit
+		 * \param nsolutions Number of solutions of the unit
+		 * \param solutions Tell if the solutions have been written in the file given by WorkQueue::output
+		 */
+		void complete(const std::string &name,uint64_t nsolutions,bool solutions);
+
+		/**
+		 * \brief Replace a claimed unit by the units of its next level
+		 *
+		 * \param name Name of the unit
+		 * \param units Units of the next level, in the format of Grid::write_line and in the order of Grid::split
+		 */
+		void split(const std::string &name,const std::vector<std::string> &units);
+
+		/**
+		 * \brief Names of the units in a state
+		 *
+		 * \param state State of the units, "pending", "running" or "done"
+		 * \return Sorted names of the units
+		 */
+		std::vector<std::string> units(const std::string &state) const;
+
+		/**
+		 * \brief Path of the file of a solved unit
+		 *
+		 * \param name Name of the unit
+		 * \param extension Extension of the file, empty string for the number of solutions and ".out" for the solutions
+		 * \return Path of the file
+		 */
+		std::string done(const std::string &name,const std::string &extension="") const {return _path+"/done/"+name+extension;}
+
+	private:
+		std::string _path;	//!< Path of the directory of the queue
+		size_t _lease;	//!< Number of seconds after which the lease of a claimed unit expires
+
+		/**
+		 * \brief Write a file atomically
+		 *
+		 * The content is written in a temporary file which is then renamed.
+		 * \param ppath Path of the file
+		 * \param content Content of the file
+		 */
+		void write_file(const std::string &ppath,const std::string &content) const;
+};
+
+#endif   /* ----- #ifndef WORKQUEUE_INC  ----- */